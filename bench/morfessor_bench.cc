@@ -0,0 +1,212 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Benchmarks for the hot paths of training and segmentation. Results are
+// printed as JSON unless another --benchmark_format is given. Build with
+// -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+
+using Corpus = morfessor::Corpus;
+using Model = morfessor::Model;
+using Segmentation = morfessor::Segmentation;
+
+namespace {
+
+// Every run shuffles the words the same way.
+constexpr unsigned int kSeed = 42;
+
+const char* const kDatasets[] = {
+  "testdata/test3.txt",
+  "testdata/test4.txt",
+  "data/wordlist.eng"
+};
+
+std::string DatasetPath(int dataset) {
+  return std::string(MORFESSOR_SOURCE_DIR) + "/" + kDatasets[dataset];
+}
+
+// Loaded once per dataset and shared by the benchmarks.
+const Corpus& LoadedCorpus(int dataset) {
+  static std::map<int, std::unique_ptr<Corpus> > corpora;
+  auto& corpus = corpora[dataset];
+  if (!corpus) {
+    corpus.reset(new Corpus(DatasetPath(dataset)));
+  }
+  return *corpus;
+}
+
+std::vector<std::string> Words(const Corpus& corpus) {
+  std::vector<std::string> words;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    words.push_back(iter->letters());
+  }
+  return words;
+}
+
+// The morfessor program's default model.
+std::shared_ptr<Model> MakeModel(const Corpus& corpus) {
+  return std::make_shared<morfessor::BaselineModel>(corpus);
+}
+
+// Makes Optimize return after its first pass over the lexicon.
+void StopAfterOneEpoch(Segmentation& segmentation) {
+  segmentation.set_seed(kSeed);
+  segmentation.set_epoch_callback(
+      [&segmentation](const morfessor::EpochStats&) { segmentation.Stop(); });
+}
+
+// A segmentation after one epoch, so the benchmarks below work on split
+// trees like those seen during training. The trees are computed once per
+// dataset and rebuilt with WarmStart.
+std::unique_ptr<Segmentation> TrainedSegmentation(int dataset) {
+  static std::map<int, std::string> trees;
+  const auto& corpus = LoadedCorpus(dataset);
+  auto& tree = trees[dataset];
+  if (tree.empty()) {
+    Segmentation segmentation(corpus, MakeModel(corpus));
+    StopAfterOneEpoch(segmentation);
+    segmentation.Optimize();
+    std::stringstream out;
+    segmentation.print_tree(out);
+    tree = out.str();
+  }
+  std::unique_ptr<Segmentation> segmentation{
+      new Segmentation(corpus, MakeModel(corpus))};
+  std::stringstream in{tree};
+  segmentation->WarmStart(in);
+  return segmentation;
+}
+
+void BM_CorpusLoad(benchmark::State& state) {
+  auto path = DatasetPath(state.range(0));
+  size_t words = 0;
+  for (auto _ : state) {
+    Corpus corpus{path};
+    words += corpus.size();
+    benchmark::DoNotOptimize(corpus);
+  }
+  state.SetItemsProcessed(words);
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+void BM_ModelInit(benchmark::State& state) {
+  const auto& corpus = LoadedCorpus(state.range(0));
+  for (auto _ : state) {
+    auto model = MakeModel(corpus);
+    benchmark::DoNotOptimize(model->overall_cost());
+  }
+  state.SetItemsProcessed(state.iterations() * corpus.size());
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+void BM_AdjustMorphCount(benchmark::State& state) {
+  auto segmentation = TrainedSegmentation(state.range(0));
+  auto words = Words(LoadedCorpus(state.range(0)));
+  size_t next = 0;
+  for (auto _ : state) {
+    // Adding and taking away a count leaves the segmentation as it was.
+    const auto& word = words[next++ % words.size()];
+    segmentation->AdjustMorphCount(word, 1);
+    segmentation->AdjustMorphCount(word, -1);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+void BM_ResplitNode(benchmark::State& state) {
+  auto segmentation = TrainedSegmentation(state.range(0));
+  auto words = Words(LoadedCorpus(state.range(0)));
+  std::mt19937 rng{kSeed};
+  std::shuffle(words.begin(), words.end(), rng);
+  size_t next = 0;
+  for (auto _ : state) {
+    const auto& word = words[next++ % words.size()];
+    if (segmentation->contains(word)) {
+      segmentation->ResplitNode(word);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+void BM_OptimizeEpoch(benchmark::State& state) {
+  const auto& corpus = LoadedCorpus(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    Segmentation segmentation(corpus, MakeModel(corpus));
+    StopAfterOneEpoch(segmentation);
+    state.ResumeTiming();
+    segmentation.Optimize();
+  }
+  state.SetItemsProcessed(state.iterations() * corpus.size());
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+void BM_SegmentTestCorpus(benchmark::State& state) {
+  auto segmentation = TrainedSegmentation(state.range(0));
+  const auto& corpus = LoadedCorpus(state.range(0));
+  for (auto _ : state) {
+    auto segments = segmentation->SegmentTestCorpus(corpus);
+    benchmark::DoNotOptimize(segments);
+  }
+  state.SetItemsProcessed(state.iterations() * corpus.size());
+  state.SetLabel(kDatasets[state.range(0)]);
+}
+
+}  // namespace
+
+BENCHMARK(BM_CorpusLoad)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ModelInit)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AdjustMorphCount)->DenseRange(0, 2);
+BENCHMARK(BM_ResplitNode)->DenseRange(0, 2);
+BENCHMARK(BM_OptimizeEpoch)->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SegmentTestCorpus)->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+  // JSON by default, so results can be compared between runs. A later
+  // --benchmark_format on the command line still wins.
+  std::string json_format = "--benchmark_format=json";
+  std::vector<char*> args(argv, argv + argc);
+  args.insert(args.begin() + 1, &json_format[0]);
+  auto arg_count = static_cast<int>(args.size());
+  benchmark::Initialize(&arg_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(arg_count, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -23,10 +23,12 @@
 #ifndef INCLUDE_CORPUS_H_
 #define INCLUDE_CORPUS_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <istream>
 
+#include "memory_usage.h"
 #include "morph.h"
 
 namespace morfessor
@@ -35,20 +37,30 @@ namespace morfessor
 class Corpus
 {
  public:
-  using iterator = std::vector<Morph>::iterator;
+  using iterator = std::vector<Morph>::const_iterator;
   using const_iterator = std::vector<Morph>::const_iterator;
   explicit Corpus(std::istream& in);
   explicit Corpus(std::string word_file);
-  size_t size() const noexcept { return words_.size(); }
-  iterator begin() noexcept { return words_.begin(); }
-  iterator end() noexcept { return words_.end(); }
-  const_iterator cbegin() const noexcept { return words_.cbegin(); }
-  const_iterator cend() const noexcept { return words_.cend(); }
+  size_t size() const noexcept { return words_->size(); }
+  iterator begin() const noexcept { return words_->cbegin(); }
+  iterator end() const noexcept { return words_->cend(); }
+  const_iterator cbegin() const noexcept { return words_->cbegin(); }
+  const_iterator cend() const noexcept { return words_->cend(); }
+
+  /// Returns the words, shared rather than copied. They never change once
+  /// the corpus is loaded, so the letters of a word stay where they are for
+  /// as long as the words are held, even after the corpus is gone.
+  std::shared_ptr<const std::vector<Morph> > words() const noexcept {
+    return words_;
+  }
+
+  /// Returns the bytes used by the words.
+  MemoryUsage memory_usage() const;
 
  private:
   void init(std::istream& in);
 
-  std::vector<Morph> words_;
+  std::shared_ptr<std::vector<Morph> > words_;
 };
 
 } // namespace morfessor
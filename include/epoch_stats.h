@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_EPOCH_STATS_H_
+#define INCLUDE_EPOCH_STATS_H_
+
+#include <cstddef>
+#include <iosfwd>
+
+#include "types.h"
+
+namespace morfessor {
+
+/// Progress report for one pass of the optimizer over the lexicon.
+struct EpochStats {
+  /// Which pass this was, starting from 1.
+  size_t epoch = 0;
+
+  /// Overall cost of the model at the end of the pass.
+  Cost overall_cost = 0;
+
+  /// Lexicon cost of the model at the end of the pass.
+  Cost lexicon_cost = 0;
+
+  /// Corpus cost of the model at the end of the pass.
+  Cost corpus_cost = 0;
+
+  /// How much the pass improved the overall cost.
+  Cost cost_delta = 0;
+
+  /// Optimization stops once cost_delta is no longer greater than this.
+  Cost convergence_threshold = 0;
+
+  /// Number of unique morphs at the end of the pass.
+  size_t unique_morph_types = 0;
+
+  /// Number of morph tokens at the end of the pass.
+  size_t total_morph_tokens = 0;
+
+  /// Number of words and morphs that were resplit during the pass.
+  size_t words_resplit = 0;
+
+  /// Wall time taken by the pass, in seconds.
+  double seconds = 0;
+
+  /// Returns how many words and morphs were resplit per second.
+  double words_per_second() const noexcept;
+};
+
+/// Prints the stats as a single line JSON object, without a newline.
+/// @param out An output stream.
+std::ostream& print_json(std::ostream& out, const EpochStats& stats);
+
+inline double EpochStats::words_per_second() const noexcept {
+  return seconds > 0 ? words_resplit / seconds : 0;
+}
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_EPOCH_STATS_H_ */
@@ -0,0 +1,122 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_EVALUATION_H_
+#define INCLUDE_EVALUATION_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "corpus.h"
+#include "segmentation.h"
+
+namespace morfessor {
+
+/// Morpheme boundary counts of a segmentation compared with a gold
+/// standard, as counted by scripts/morpho-challenge-eval.perl.
+struct BoundaryScore {
+  /// Boundaries in both the segmentation and the gold standard.
+  size_t hits = 0;
+
+  /// Boundaries only in the segmentation.
+  size_t insertions = 0;
+
+  /// Boundaries only in the gold standard.
+  size_t deletions = 0;
+
+  /// Number of words that were in the gold standard.
+  size_t evaluated_words = 0;
+
+  /// Number of words that were segmented.
+  size_t segmented_words = 0;
+
+  /// Returns the fraction of the suggested boundaries that are correct, or
+  /// 1 if there are none.
+  double precision() const noexcept;
+
+  /// Returns the fraction of the gold standard boundaries that were found,
+  /// or 1 if there are none.
+  double recall() const noexcept;
+
+  /// Returns the harmonic mean of precision and recall, or 1 if there are
+  /// no boundaries at all.
+  double fmeasure() const noexcept;
+
+  BoundaryScore& operator+=(const BoundaryScore& other) noexcept;
+};
+
+/// Correct segmentations of words, read from a file in the Morpho Challenge
+/// gold standard format: "word<TAB>morph morph, morph morph" with one or
+/// more alternative analyses per word.
+class GoldStandard {
+ public:
+  /// C'tor.
+  /// @throws std::runtime_error if a line is not a word and its analyses,
+  ///   or an analysis does not spell the word.
+  explicit GoldStandard(std::istream& in);
+
+  /// C'tor.
+  /// @throws std::runtime_error if the file cannot be read or is not a
+  ///   gold standard.
+  explicit GoldStandard(const std::string& gold_file);
+
+  /// Returns the number of words in the gold standard.
+  size_t size() const noexcept { return analyses_.size(); }
+
+  /// Scores the segmentation of one word against the alternative analysis
+  /// that matches it best. Words not in the gold standard only count as
+  /// segmented.
+  /// @param boundaries The end offset of each morph, the last one being
+  ///   the length of the word, as written by Segmentation::SegmentWord.
+  BoundaryScore Score(const std::string& word, const size_t* boundaries,
+      size_t morph_count) const;
+
+  /// Scores one line of segmentation output, with the morphs separated by
+  /// spaces.
+  BoundaryScore Score(const std::string& segmented_word) const;
+
+ private:
+  void init(std::istream& in);
+
+  /// Inner boundary offsets of each alternative analysis of each word.
+  std::unordered_map<std::string, std::vector<std::vector<size_t> > >
+      analyses_;
+};
+
+/// Segments every word of a test corpus and scores the segmentations
+/// against a gold standard, on several threads and without writing the
+/// segmentations anywhere.
+/// @param threads Number of worker threads. 0 means one per hardware
+///   thread.
+BoundaryScore Evaluate(const Segmentation& segmentation,
+    const Corpus& test_corpus, const GoldStandard& gold, size_t threads = 0);
+
+/// Writes the score in the same format as morpho-challenge-eval.perl.
+std::ostream& print_table(std::ostream& out, const BoundaryScore& score);
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_EVALUATION_H_ */
@@ -0,0 +1,141 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_INSTRUMENTATION_H_
+#define INCLUDE_INSTRUMENTATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace morfessor {
+
+/// Counts of the work done on the hot paths, and the time spent in each
+/// phase of a run. Nothing is collected until Enable is called, and until
+/// then each counting site costs one well predicted branch.
+namespace instrumentation {
+
+/// What is counted.
+enum class Counter : size_t {
+  /// Calls to Segmentation::AdjustMorphCount.
+  kAdjustMorphCountCalls,
+  /// Tree nodes visited by AdjustMorphCount.
+  kAdjustMorphCountNodes,
+  /// The most nodes ever waiting on AdjustMorphCount's stack. This takes
+  /// the place of the recursion depth, since the walk is iterative.
+  kAdjustMorphCountMaxStack,
+  /// Lookups in the split tree hash table.
+  kNodeLookups,
+  /// Nodes added to the split tree hash table.
+  kNodeInserts,
+  /// Nodes removed from the split tree hash table.
+  kNodeErases,
+  /// Calls to Segmentation::ResplitNode.
+  kResplitNodeCalls,
+  /// Split points tried by ResplitNode.
+  kSplitCandidates,
+  /// Words segmented with the Viterbi algorithm.
+  kViterbiWords,
+  /// Viterbi cells evaluated, one for each morph considered.
+  kViterbiCells,
+  kCount
+};
+
+/// The phases of a run that are timed.
+enum class Phase : size_t {
+  kLoad,
+  kModelInit,
+  kOptimize,
+  kOutput,
+  kCount
+};
+
+namespace detail {
+
+extern std::atomic<bool> enabled;
+extern std::atomic<uint64_t> counters[static_cast<size_t>(Counter::kCount)];
+
+}  // namespace detail
+
+/// Starts or stops collecting.
+void Enable(bool enable = true);
+
+/// Returns true if counts and timings are being collected.
+inline bool enabled() {
+  return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/// Adds to a counter.
+inline void Count(Counter counter, uint64_t amount = 1) {
+  if (enabled()) {
+    detail::counters[static_cast<size_t>(counter)].fetch_add(amount,
+        std::memory_order_relaxed);
+  }
+}
+
+/// Raises a counter to value, if it is lower.
+void CountMax(Counter counter, uint64_t value);
+
+/// Adds time to a phase.
+void AddTime(Phase phase, std::chrono::steady_clock::duration time);
+
+/// Returns the value of a counter.
+uint64_t value(Counter counter);
+
+/// Returns the seconds spent in a phase.
+double seconds(Phase phase);
+
+/// Sets all counters and timings back to zero.
+void Reset();
+
+/// Adds the time from construction to destruction to a phase, or to
+/// several phases one after the other.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(Phase phase);
+  ~PhaseTimer();
+
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  /// Adds the time so far to the current phase and starts timing another.
+  void Switch(Phase phase);
+
+ private:
+  Phase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/// Prints the counters, some averages derived from them and the phase
+/// timings as a table, one line each.
+std::ostream& print_table(std::ostream& out);
+
+/// Prints the same as print_table as a JSON object, without a newline.
+std::ostream& print_json(std::ostream& out);
+
+}  // namespace instrumentation
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_INSTRUMENTATION_H_ */
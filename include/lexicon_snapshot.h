@@ -0,0 +1,183 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_LEXICON_SNAPSHOT_H_
+#define INCLUDE_LEXICON_SNAPSHOT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+#include "viterbi.h"
+
+namespace morfessor {
+
+/// An unchangeable copy of the lexicon of a segmentation, holding only what
+/// decoding needs. Any number of threads can decode with it at once.
+class LexiconSnapshot {
+ public:
+  /// C'tor.
+  /// @param morph_costs The cost of using each morph in the lexicon.
+  /// @param log_token_count Log of the number of morph tokens.
+  /// @param epoch The number of passes the optimizer had made.
+  LexiconSnapshot(std::unordered_map<std::string, Cost> morph_costs,
+      Cost log_token_count, size_t epoch);
+
+  /// Returns the best segmentation of a word, found with the Viterbi
+  /// algorithm.
+  /// @return The index one past the end of each morph in the word.
+  std::vector<size_t> SegmentWord(const std::string& word) const;
+
+  /// \overload
+  /// @param word The letters of the word to segment.
+  /// @param length The number of letters in the word.
+  /// @param buffers Working memory.
+  /// @param boundaries Receives the index one past the end of each morph.
+  ///   Must have room for length indices.
+  /// @return The number of morphs.
+  size_t SegmentWord(const char* word, size_t length, DecodeBuffers& buffers,
+      size_t* boundaries) const;
+
+  /// Returns the number of passes the optimizer had made.
+  size_t epoch() const noexcept { return epoch_; }
+
+  /// Returns the number of morphs in the lexicon.
+  size_t size() const noexcept { return morph_costs_.size(); }
+
+ private:
+  /// The cost of using each morph.
+  std::unordered_map<std::string, Cost> morph_costs_;
+
+  /// Log of the number of morph tokens.
+  Cost log_token_count_;
+
+  /// The length of the longest morph, beyond which no lookups are needed.
+  size_t max_morph_length_ = 0;
+
+  /// The number of passes the optimizer had made.
+  size_t epoch_;
+};
+
+/// Hands the latest lexicon snapshot to readers that never wait for a
+/// lock, using epoch based reclamation: a replaced snapshot is only freed
+/// once every reader that could have picked it up has let go of it.
+class SnapshotPublisher {
+ public:
+  /// Registers a reader thread. Each thread that reads needs its own.
+  class Reader {
+   public:
+    /// C'tor.
+    /// @throws std::runtime_error if the maximum number of readers are
+    ///   already registered.
+    explicit Reader(SnapshotPublisher& publisher);
+
+    /// D'tor. Releases the snapshot, if any.
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /// Returns the latest snapshot, or null if none was published yet. It
+    /// stays valid until Release or Acquire is called again.
+    const LexiconSnapshot* Acquire();
+
+    /// Lets go of the snapshot returned by Acquire.
+    void Release();
+
+   private:
+    /// The publisher read from.
+    SnapshotPublisher& publisher_;
+
+    /// The index of this reader's slot in the publisher.
+    size_t slot_;
+  };
+
+  /// C'tor.
+  /// @param max_readers The maximum number of readers registered at once.
+  explicit SnapshotPublisher(size_t max_readers = 64);
+
+  /// D'tor. Frees the snapshots. No readers may be left.
+  ~SnapshotPublisher();
+
+  SnapshotPublisher(const SnapshotPublisher&) = delete;
+  SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+  /// Makes a snapshot the latest one, and frees the snapshots replaced
+  /// earlier that no reader can be using anymore.
+  void Publish(std::unique_ptr<const LexiconSnapshot> snapshot);
+
+  /// Frees the replaced snapshots that no reader can be using anymore.
+  void Reclaim();
+
+  /// Returns the number of replaced snapshots that are not freed yet.
+  size_t retired() const;
+
+ private:
+  /// Marks a reader as idle.
+  static constexpr uint64_t kIdle = UINT64_MAX;
+
+  /// Per reader state, aligned so readers don't share cache lines.
+  struct alignas(64) Slot {
+    /// Set while a Reader owns the slot.
+    std::atomic<bool> in_use{false};
+
+    /// The publisher epoch when the reader acquired its snapshot, or kIdle.
+    std::atomic<uint64_t> epoch{kIdle};
+
+    /// Allocates slots on a cache line boundary, which plain new does not
+    /// do for over-aligned types before C++17.
+    static void* operator new[](size_t size);
+    static void operator delete[](void* slots) noexcept;
+  };
+
+  /// Frees retired snapshots. Must be called with writer_mutex_ held.
+  void ReclaimLocked();
+
+  /// The latest snapshot, owned by the publisher.
+  std::atomic<const LexiconSnapshot*> current_{nullptr};
+
+  /// Incremented every time a snapshot is published.
+  std::atomic<uint64_t> epoch_{0};
+
+  /// One slot per reader.
+  std::unique_ptr<Slot[]> slots_;
+
+  /// Number of slots.
+  size_t slot_count_;
+
+  /// Serializes publishers.
+  mutable std::mutex writer_mutex_;
+
+  /// Replaced snapshots and the epoch they were replaced in.
+  std::vector<std::pair<uint64_t, const LexiconSnapshot*> > retired_;
+};
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_LEXICON_SNAPSHOT_H_ */
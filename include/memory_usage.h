@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_MEMORY_USAGE_H_
+#define INCLUDE_MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace morfessor {
+
+/// Bytes used by one data structure, broken down into parts. The sizes are
+/// estimates for the GNU standard library's containers, and leave out the
+/// allocator's own overhead.
+struct MemoryUsage {
+  /// The name of each part and the bytes it uses.
+  std::vector<std::pair<std::string, size_t> > parts;
+
+  /// Returns the bytes used by all the parts.
+  size_t total() const;
+};
+
+/// Returns the bytes a string has allocated outside of itself, which is
+/// nothing for strings short enough to be stored inline.
+size_t heap_bytes(const std::string& str);
+
+/// Returns the bytes of one node of an unordered_map or unordered_set
+/// holding values of the given type, assuming the hash is cached in it.
+template <class Value>
+constexpr size_t hash_node_bytes() {
+  return sizeof(void*) + sizeof(Value) + sizeof(size_t);
+}
+
+/// Returns the bytes of the nodes and buckets of an unordered_map, without
+/// anything its keys and values allocate themselves.
+template <class Map>
+size_t hash_table_bytes(const Map& map) {
+  return map.size() * hash_node_bytes<typename Map::value_type>() +
+      map.bucket_count() * sizeof(void*);
+}
+
+/// Returns the highest resident set size of the process so far in bytes,
+/// or 0 if it is not known.
+size_t peak_rss_bytes();
+
+/// Prints the parts of several data structures as a table, one line each.
+/// @param usages Each data structure's name and memory usage.
+std::ostream& print_table(std::ostream& out,
+    const std::vector<std::pair<std::string, MemoryUsage> >& usages);
+
+/// Prints the same as print_table as a JSON object, without a newline.
+std::ostream& print_json(std::ostream& out,
+    const std::vector<std::pair<std::string, MemoryUsage> >& usages);
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_MEMORY_USAGE_H_ */
@@ -27,15 +27,69 @@
 #include <cmath>
 #include <cassert>
 #include <unordered_map>
+#include <iosfwd>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/math/distributions/gamma.hpp>
 
 #include "corpus.h"
+#include "memory_usage.h"
 #include "types.h"
 
 namespace morfessor {
 
+/// Records how the count of a single leaf morph changed, so that the cost
+/// adjustments for many leaves can be applied to the model together.
+struct MorphCountChange {
+  /// The leaf morph whose count changed.
+  std::string morph;
+
+  /// The count of the morph before the change.
+  size_t old_count;
+
+  /// The count of the morph after the change.
+  size_t new_count;
+};
+
+/// How often each letter occurs in a corpus, weighted by the word
+/// frequencies. The counts do not depend on the algorithm or its
+/// parameters, so they can be counted once and shared by several models.
+struct LetterStatistics {
+  /// C'tor for a corpus without any words.
+  LetterStatistics() = default;
+
+  /// C'tor that counts the letters of every word in the corpus.
+  /// @param threads Number of threads to count on. 0 means one per
+  ///   hardware thread. The counts do not depend on it.
+  explicit LetterStatistics(const Corpus& corpus, size_t threads = 1);
+
+  /// Adds the letters of every word in the corpus to the counts. Chunks of
+  /// the corpus are counted on their own and added up in order.
+  /// @param threads Number of threads to count on. 0 means one per
+  ///   hardware thread. The counts do not depend on it.
+  void Add(const Corpus& corpus, size_t threads = 1);
+
+  /// Number of times each letter appears.
+  std::unordered_map<char, size_t> counts;
+
+  /// Number of letter tokens, not counting end of morph markers.
+  size_t total_letters = 0;
+
+  /// Number of word tokens, which is also the number of end of morph
+  /// markers.
+  size_t total_words = 0;
+};
+
+/// Returns the algorithm a --mode name stands for.
+/// @param name Baseline, Freq, Length or FreqLength.
+/// @throws std::invalid_argument for any other name.
+AlgorithmModes ParseAlgorithmMode(const std::string& name);
+
+/// Returns the --mode name of an algorithm.
+const char* AlgorithmModeName(AlgorithmModes mode);
+
 class Model {
  public:
   /// Makes a model for analyzing the corpus using the chosen algorithm.
@@ -45,8 +99,20 @@ class Model {
   /// @param convergence Must be > 0 and < 1.
   /// @param most_common_morph_length Must be > 0 and < 24*beta.
   /// @param beta Must be > 0.
+  /// @param threads Number of threads to go over the corpus with. 0 means
+  ///   one per hardware thread. The corpus is summed up in chunks of a
+  ///   fixed size that are added together in order, so the costs come out
+  ///   the same however many threads there are.
   Model(const Corpus& corpus, AlgorithmModes mode, double hapax,
-      double most_common_morph_len, double beta);
+      double most_common_morph_len, double beta, size_t threads = 1);
+
+  /// \overload
+  /// @param letters The letter statistics of the corpus, counted once for
+  ///   several models. Pass an rvalue to hand over the counts without
+  ///   copying them.
+  Model(const Corpus& corpus, LetterStatistics letters,
+      AlgorithmModes mode, double hapax, double most_common_morph_len,
+      double beta, size_t threads = 1);
 
   /// D'tor.
   virtual ~Model();
@@ -86,6 +152,12 @@ class Model {
   /// Returns the map of individual letter costs.
   std::unordered_map<char, Cost> letter_costs() const noexcept;
 
+  /// Returns the letter counts the letter costs are computed from.
+  const LetterStatistics& letter_statistics() const noexcept;
+
+  /// Returns the bytes used by the letter tables.
+  MemoryUsage memory_usage() const;
+
   /// Adds or subtracts from the morph token count.
   /// @param delta The number of tokens to add or remove.
   void adjust_morph_token_count(int delta);
@@ -107,14 +179,67 @@ class Model {
   /// Adjust the string cost based on what string was added or removed.
   void adjust_string_cost(const std::string& str, bool add);
 
+  /// Adds the letters of newly arrived words to the letter statistics and
+  /// recalculates the letter costs. The string costs of morphs already in
+  /// the lexicon are not updated; Segmentation::Update takes care of that.
+  /// @param new_words New words, or frequency increments for known words.
+  void AddLetterCounts(const Corpus& new_words);
+
+  /// Writes the letter statistics and cost accumulators, exactly, so that
+  /// the model can be restored later with LoadState.
+  /// @param out An output stream.
+  void SaveState(std::ostream& out) const;
+
+  /// Restores the letter statistics and cost accumulators saved by
+  /// SaveState. The model has to use the same algorithm mode and
+  /// parameters as the one that was saved.
+  /// @param in An input stream.
+  /// @throw runtime_error if the state could not be read or was saved by
+  ///   a model using a different algorithm mode.
+  void LoadState(std::istream& in);
+
+  /// Applies the adjustments for a batch of leaf morph count changes in a
+  /// single pass. Equivalent to calling adjust_morph_token_count,
+  /// adjust_unique_morph_count and the cost adjustments for each change in
+  /// turn, but each accumulator is only updated once.
+  /// @param changes The leaf morphs whose counts changed, in any order.
+  void adjust_leaf_counts(const std::vector<MorphCountChange>& changes);
+
+  /// \overload
+  /// @param changes The first change.
+  /// @param count The number of changes.
+  void adjust_leaf_counts(const MorphCountChange* changes, size_t count);
+
  private:
+  /// What the words of part of a corpus add to the model's counts and
+  /// costs when they are put in unsplit.
+  struct CorpusCosts {
+    size_t types = 0;
+    size_t tokens = 0;
+    Cost frequencies = 0;
+    Cost lengths = 0;
+    Cost strings = 0;
+    Cost log_token_sum = 0;
+
+    /// Compensation for the rounding error in log_token_sum.
+    Cost log_token_sum_error = 0;
+
+    /// Adds the costs of the words that come after these.
+    void Add(const CorpusCosts& later);
+  };
+
+  /// Sums up the costs of a range of words, in order.
+  CorpusCosts CountCorpusCosts(Corpus::const_iterator begin,
+      Corpus::const_iterator end) const;
+
   /// Recalculates the probabilities of each letter in the corpus, and the
-  /// end-of-morph marker.
-  /// @param include_end_of_string Whether to consider "end of string" a
-  ///   letter when computing probabilities. Should be true when using
-  ///   the implicit length variants of the algorithm.
-  /// @return A map of letters to code lengths
-  void UpdateLetterProbabilities(const Corpus& corpus);
+  /// end-of-morph marker, from the current letter counts. The "end of
+  /// string" marker is only considered a letter when using the implicit
+  /// length variants of the algorithm.
+  void UpdateLetterProbabilities();
+
+  /// Adds a term to the corpus log token sum using compensated summation.
+  void add_to_corpus_log_token_sum(Cost term);
 
   /// Whether to use the zipf distribution for morph lengths.
   bool explicit_length() const noexcept;
@@ -150,6 +275,10 @@ class Model {
   /// Part of the corpus cost.
   Cost cost_from_corpus_log_token_sum_ = 0;
 
+  /// Running compensation for the rounding error in
+  /// cost_from_corpus_log_token_sum_.
+  Cost corpus_log_token_sum_error_ = 0;
+
   /// Number of morph tokens in the data structure. Whereas unique_morph_types_
   /// equals the number of unique morphs, this number factors in the frequency
   /// of each morph in the corpus.
@@ -180,24 +309,28 @@ class Model {
   /// Contains the probabilities of each letter in the corpus.
   /// The "end of morph" marker is ' '.
   std::unordered_map<char, Cost> letter_probabilities_;
+
+  /// Number of times each letter appears in the corpus, factoring in word
+  /// frequencies. Kept so that new words can be added later on.
+  LetterStatistics letters_;
 };
 
 class BaselineModel : public Model {
  public:
-  BaselineModel(const Corpus& corpus);
+  BaselineModel(const Corpus& corpus, size_t threads = 1);
 };
 
 class BaselineLengthModel : public Model {
  public:
   BaselineLengthModel(const Corpus& corpus,
       double most_common_morph_length = 7.0,
-      double beta = 1.0);
+      double beta = 1.0, size_t threads = 1);
 };
 
 class BaselineFrequencyModel : public Model {
  public:
   BaselineFrequencyModel(const Corpus& corpus,
-      double hapax_legomena_prior = 0.5);
+      double hapax_legomena_prior = 0.5, size_t threads = 1);
 };
 
 class BaselineFrequencyLengthModel : public Model {
@@ -205,13 +338,17 @@ class BaselineFrequencyLengthModel : public Model {
   BaselineFrequencyLengthModel(const Corpus& corpus,
       double hapax_legomena_prior = 0.5,
       double most_common_morph_length = 7.0,
-      double beta = 1.0);
+      double beta = 1.0, size_t threads = 1);
 };
 
 inline std::unordered_map<char, Cost> Model::letter_costs() const noexcept {
   return letter_probabilities_;
 }
 
+inline const LetterStatistics& Model::letter_statistics() const noexcept {
+  return letters_;
+}
+
 inline Cost Model::convergence_threshold() const noexcept {
   return convergence_threshold_ * unique_morph_types_;
 }
@@ -282,8 +419,19 @@ inline Cost Model::corpus_cost() const {
 }
 
 inline void Model::adjust_corpus_cost(int delta_morph_frequency) {
-    cost_from_corpus_log_token_sum_ +=
-        delta_morph_frequency * std::log(std::abs(delta_morph_frequency));
+  add_to_corpus_log_token_sum(
+      delta_morph_frequency * std::log(std::abs(delta_morph_frequency)));
+}
+
+inline void Model::add_to_corpus_log_token_sum(Cost term) {
+  // The sum is large compared to the terms, and the same terms are added
+  // and removed again millions of times while training. Kahan summation
+  // keeps the rounding errors from piling up.
+  auto compensated_term = term - corpus_log_token_sum_error_;
+  auto new_sum = cost_from_corpus_log_token_sum_ + compensated_term;
+  corpus_log_token_sum_error_ =
+      (new_sum - cost_from_corpus_log_token_sum_) - compensated_term;
+  cost_from_corpus_log_token_sum_ = new_sum;
 }
 
 // Length cost
@@ -0,0 +1,129 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// @file
+/// C interface to libmorfessor, for segmenting words with a trained model
+/// from C, C++ or any language with a C foreign function interface.
+///
+/// A loaded model is never changed, so any number of threads can segment
+/// words with the same model at the same time.
+
+#ifndef INCLUDE_MORFESSOR_H_
+#define INCLUDE_MORFESSOR_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of this interface. Only changes when it changes incompatibly.
+#define MORFESSOR_API_VERSION 1
+
+/// A trained model, loaded from a file.
+typedef struct morfessor_model morfessor_model;
+
+/// The result of a call.
+typedef enum morfessor_status {
+  MORFESSOR_OK = 0,
+  /// The model file could not be read.
+  MORFESSOR_ERROR_IO = 1,
+  /// An argument was null or out of range.
+  MORFESSOR_ERROR_INVALID_ARGUMENT = 2,
+  /// The boundaries buffer is too small for the words.
+  MORFESSOR_ERROR_BUFFER_TOO_SMALL = 3,
+  /// Memory ran out.
+  MORFESSOR_ERROR_OUT_OF_MEMORY = 4,
+  /// Anything else went wrong.
+  MORFESSOR_ERROR_INTERNAL = 5
+} morfessor_status;
+
+/// The cost model the segmentation was trained with.
+typedef enum morfessor_model_type {
+  MORFESSOR_BASELINE = 0,
+  MORFESSOR_BASELINE_FREQUENCY = 1,
+  MORFESSOR_BASELINE_LENGTH = 2,
+  MORFESSOR_BASELINE_FREQUENCY_LENGTH = 3
+} morfessor_model_type;
+
+/// Parameters of the cost model, as given to the morfessor program when
+/// the model was trained.
+typedef struct morfessor_options {
+  /// The cost model. Defaults to MORFESSOR_BASELINE, the morfessor
+  /// program's default mode.
+  morfessor_model_type model_type;
+
+  /// Prior probability for the proportion of morphs that only appear once.
+  /// Must be in range (0,1). Defaults to 0.5.
+  double hapax;
+
+  /// Most common morph length. Defaults to 7.
+  double most_common_length;
+
+  /// Beta value for the morph length Gamma distribution. Defaults to 1.
+  double beta;
+} morfessor_options;
+
+/// Fills in the default options.
+void morfessor_default_options(morfessor_options* options);
+
+/// Loads a model saved by the morfessor program.
+/// @param path The model file.
+/// @param options The cost model parameters, or null for the defaults.
+/// @param model Receives the model, which must be freed with
+///   morfessor_free.
+/// @return MORFESSOR_OK, or an error if nothing was loaded.
+morfessor_status morfessor_load(const char* path,
+    const morfessor_options* options, morfessor_model** model);
+
+/// Frees a model. Does nothing if model is null.
+void morfessor_free(morfessor_model* model);
+
+/// Segments a batch of words. Nothing is allocated for each word, and the
+/// results are written to buffers owned by the caller.
+///
+/// The morphs of word i end at boundaries[offsets[i]] up to, but not
+/// including, boundaries[offsets[i + 1]]. Each end is an index one past
+/// the last byte of the morph, so the last one is the length of the word.
+///
+/// @param model The model.
+/// @param words The words, which need not be null terminated.
+/// @param lengths The length of each word in bytes.
+/// @param count The number of words.
+/// @param boundaries Receives the morph ends. A word has at most as many
+///   morphs as bytes, so capacity must be at least the total length of the
+///   words.
+/// @param capacity The number of elements in boundaries.
+/// @param offsets Receives count + 1 offsets into boundaries.
+/// @return MORFESSOR_OK, or an error if nothing was segmented.
+morfessor_status morfessor_segment(const morfessor_model* model,
+    const char* const* words, const size_t* lengths, size_t count,
+    size_t* boundaries, size_t capacity, size_t* offsets);
+
+/// Returns a description of a status, which must not be freed.
+const char* morfessor_status_string(morfessor_status status);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif /* INCLUDE_MORFESSOR_H_ */
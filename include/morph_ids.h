@@ -0,0 +1,187 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_MORPH_IDS_H_
+#define INCLUDE_MORPH_IDS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+#include "viterbi.h"
+
+namespace morfessor {
+
+/// Stable integer IDs for the morphs of a trained lexicon, for programs
+/// that consume segmentations as numbers rather than strings.
+///
+/// IDs are given out by descending count and then by the bytes of the
+/// morph, so the same lexicon always gets the same IDs and the most common
+/// morphs get the smallest ones. ID 0 is kUnknownMorphId, for letters that
+/// are not in the lexicon.
+class MorphVocabulary {
+ public:
+  /// C'tor.
+  /// @param morph_counts Every morph the decoder may use, and its count.
+  /// @param log_token_count Log of the number of morph tokens.
+  MorphVocabulary(std::vector<std::pair<std::string, size_t> > morph_counts,
+      Cost log_token_count);
+
+  /// Returns the number of IDs, including kUnknownMorphId.
+  size_t size() const noexcept { return morphs_.size(); }
+
+  /// Returns the morph with an ID, or an empty string for
+  /// kUnknownMorphId.
+  /// @param id The ID. Must be < size().
+  const std::string& morph(uint32_t id) const;
+
+  /// Returns the count of the morph with an ID, or 0 for kUnknownMorphId.
+  /// @param id The ID. Must be < size().
+  size_t count(uint32_t id) const;
+
+  /// Finds the best segmentation of a word, as Segmentation::SegmentWord
+  /// does, and the IDs of its morphs.
+  /// @param word The letters of the word to segment.
+  /// @param length The number of letters in the word.
+  /// @param buffers Working memory.
+  /// @param boundaries Receives the index one past the end of each morph.
+  ///   Must have room for length indices.
+  /// @param ids Receives the ID of each morph. Must have room for length
+  ///   IDs.
+  /// @return The number of morphs.
+  size_t SegmentWord(const char* word, size_t length, DecodeBuffers& buffers,
+      size_t* boundaries, uint32_t* ids) const;
+
+  /// Prints one line per ID, in order: the ID, the morph and its count,
+  /// separated by tabs. The line of kUnknownMorphId has an empty morph.
+  /// @param out An output stream.
+  std::ostream& print(std::ostream& out) const;
+
+ private:
+  /// What the decoder needs to know about a morph.
+  struct Entry {
+    uint32_t id;
+    Cost cost;
+  };
+
+  /// The ID and cost of each morph.
+  std::unordered_map<std::string, Entry> entries_;
+
+  /// The morph and count of each ID.
+  std::vector<std::pair<std::string, size_t> > morphs_;
+
+  /// Log of the number of morph tokens.
+  Cost log_token_count_;
+
+  /// The length of the longest morph, beyond which no lookups are needed.
+  size_t max_morph_length_ = 0;
+};
+
+/// How MorphIdWriter packs IDs.
+enum class MorphIdEncoding {
+  /// Little-endian base 128, 7 bits per byte with the high bit set on all
+  /// but the last byte of an ID. Common morphs take a single byte.
+  kVarint,
+  /// Four bytes per ID, little-endian.
+  kFixed32
+};
+
+/// Writes the morph IDs of a sequence of words as a packed stream, with an
+/// index of where each word starts.
+///
+/// The index holds one little-endian 64 bit byte offset into the stream
+/// per word, and a final one with the length of the stream, so the IDs of
+/// word i are the bytes between offsets i and i + 1.
+class MorphIdWriter {
+ public:
+  /// C'tor.
+  /// @param ids Receives the packed IDs. Should be opened in binary mode.
+  /// @param offsets Receives the index. Should be opened in binary mode.
+  /// @param encoding How to pack the IDs.
+  MorphIdWriter(std::ostream& ids, std::ostream& offsets,
+      MorphIdEncoding encoding);
+
+  /// D'tor. Calls Finish if it was not called yet.
+  ~MorphIdWriter();
+
+  MorphIdWriter(const MorphIdWriter&) = delete;
+  MorphIdWriter& operator=(const MorphIdWriter&) = delete;
+
+  /// Adds the IDs of the next word.
+  /// @param ids The IDs of the morphs of the word.
+  /// @param count The number of morphs.
+  void Add(const uint32_t* ids, size_t count);
+
+  /// Writes what is still buffered and the final offset.
+  void Finish();
+
+  /// Returns the number of words added.
+  size_t words() const noexcept { return words_; }
+
+ private:
+  /// Writes the buffers to the streams once they are this big.
+  static constexpr size_t kFlushSize = 1 << 16;
+
+  /// Writes the buffers to the streams.
+  void Flush();
+
+  /// Appends a little-endian integer to a buffer.
+  template <class T>
+  static void AppendFixed(std::string& buffer, T value);
+
+  std::ostream& ids_out_;
+  std::ostream& offsets_out_;
+  MorphIdEncoding encoding_;
+
+  /// Packed IDs not written yet.
+  std::string ids_;
+
+  /// Offsets not written yet.
+  std::string offsets_;
+
+  /// Bytes of IDs so far, written or not.
+  uint64_t position_ = 0;
+
+  /// Number of words added.
+  size_t words_ = 0;
+
+  /// Set by Finish.
+  bool finished_ = false;
+};
+
+/// Unpacks the IDs of one word written by MorphIdWriter.
+/// @param data The bytes between two offsets of the index.
+/// @param length The number of bytes.
+/// @param encoding How the IDs were packed.
+/// @param ids Receives the IDs, replacing what it held.
+/// @throws std::runtime_error if the bytes are not valid IDs.
+void UnpackMorphIds(const char* data, size_t length,
+    MorphIdEncoding encoding, std::vector<uint32_t>& ids);
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_MORPH_IDS_H_ */
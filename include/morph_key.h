@@ -0,0 +1,216 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_MORPH_KEY_H_
+#define INCLUDE_MORPH_KEY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <utility>
+
+namespace morfessor {
+
+/// Returns a 64-bit hash of a string of letters, mixing in eight letters at
+/// a time the way MurmurHash64A does. Hashing happens on every lookup in
+/// the split trees, so it has to be cheap; the value is only meant for
+/// in-memory hash tables and may differ between platforms.
+/// @param letters The letters.
+/// @param length The number of letters.
+inline uint64_t HashLetters(const char* letters, size_t length) noexcept;
+
+/// The letters of a morph, as a key in the data structure of a
+/// Segmentation. A key either views letters that are stored elsewhere, such
+/// as the words of a corpus, or owns a copy of them. Copying a view gives
+/// another view of the same letters, so a view must not outlive them.
+class MorphKey {
+ public:
+  /// Returns a key that views letters stored elsewhere, without copying
+  /// them.
+  /// @param letters The letters. Must outlive the key and its copies.
+  /// @param length The number of letters.
+  static MorphKey View(const char* letters, size_t length) noexcept {
+    return MorphKey(letters, length, false);
+  }
+
+  /// \overload
+  static MorphKey View(const std::string& letters) noexcept;
+
+  /// Returns a key that owns a copy of some letters.
+  /// @param letters The letters.
+  /// @param length The number of letters.
+  static MorphKey Copy(const char* letters, size_t length);
+
+  /// \overload
+  static MorphKey Copy(const std::string& letters);
+
+  MorphKey(const MorphKey& other);
+  MorphKey(MorphKey&& other) noexcept;
+  MorphKey& operator=(const MorphKey& other);
+  MorphKey& operator=(MorphKey&& other) noexcept;
+  ~MorphKey();
+
+  const char* data() const noexcept { return data_; }
+  size_t length() const noexcept { return length_; }
+  bool empty() const noexcept { return length_ == 0; }
+  const char* begin() const noexcept { return data_; }
+  const char* end() const noexcept { return data_ + length_; }
+
+  /// Returns the HashLetters hash of the letters, computed when the key
+  /// was made.
+  uint64_t hash() const noexcept { return hash_; }
+
+  /// Returns true if the key owns its letters rather than viewing them.
+  bool owns_letters() const noexcept { return owns_letters_; }
+
+  /// Returns some of the letters of the key. The part of a view is a view
+  /// of the same letters, and the part of a key that owns its letters owns
+  /// a copy.
+  /// @param pos The index of the first letter.
+  /// @param length The number of letters.
+  MorphKey substr(size_t pos, size_t length) const;
+
+  /// Returns a copy of the letters.
+  std::string str() const { return std::string(data_, length_); }
+
+ private:
+  MorphKey(const char* data, size_t length, bool owns_letters) noexcept
+      : data_{data}, length_{length}, hash_{HashLetters(data, length)},
+        owns_letters_{owns_letters} {}
+
+  const char* data_;
+  size_t length_;
+
+  // Kept with the key, since a hash table looks at the hashes of the keys
+  // it stores over and over, and standard libraries do not all keep them.
+  uint64_t hash_;
+
+  bool owns_letters_;
+};
+
+inline bool operator==(const MorphKey& left, const MorphKey& right)
+    noexcept {
+  return left.hash() == right.hash() && left.length() == right.length() &&
+      (left.data() == right.data() || left.empty() ||
+          std::memcmp(left.data(), right.data(), left.length()) == 0);
+}
+
+/// Orders keys by their letters, like std::string does.
+bool operator<(const MorphKey& left, const MorphKey& right) noexcept;
+
+std::ostream& operator<<(std::ostream& out, const MorphKey& key);
+
+inline uint64_t HashLetters(const char* letters, size_t length) noexcept {
+  const uint64_t multiplier = 0xc6a4a7935bd1e995ull;
+  const int shift = 47;
+  uint64_t hash = length * multiplier;
+
+  auto end = letters + (length & ~size_t{7});
+  for (; letters != end; letters += 8) {
+    uint64_t block;
+    std::memcpy(&block, letters, sizeof(block));
+    block *= multiplier;
+    block ^= block >> shift;
+    block *= multiplier;
+    hash ^= block;
+    hash *= multiplier;
+  }
+
+  // The last one to seven letters.
+  if (length & 7) {
+    uint64_t block = 0;
+    for (size_t i = 0; i < (length & 7); ++i) {
+      block |= uint64_t{static_cast<unsigned char>(letters[i])} << (8 * i);
+    }
+    hash ^= block;
+    hash *= multiplier;
+  }
+
+  hash ^= hash >> shift;
+  hash *= multiplier;
+  hash ^= hash >> shift;
+  return hash;
+}
+
+inline MorphKey::MorphKey(const MorphKey& other)
+    : data_{other.data_}, length_{other.length_}, hash_{other.hash_},
+      owns_letters_{false} {
+  if (other.owns_letters_) {
+    *this = Copy(other.data_, other.length_);
+  }
+}
+
+inline MorphKey::MorphKey(MorphKey&& other) noexcept
+    : data_{other.data_}, length_{other.length_}, hash_{other.hash_},
+      owns_letters_{other.owns_letters_} {
+  other.data_ = nullptr;
+  other.length_ = 0;
+  other.hash_ = HashLetters(nullptr, 0);
+  other.owns_letters_ = false;
+}
+
+inline MorphKey& MorphKey::operator=(const MorphKey& other) {
+  if (this != &other) {
+    *this = MorphKey(other);
+  }
+  return *this;
+}
+
+inline MorphKey& MorphKey::operator=(MorphKey&& other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(length_, other.length_);
+  std::swap(hash_, other.hash_);
+  std::swap(owns_letters_, other.owns_letters_);
+  return *this;
+}
+
+inline MorphKey::~MorphKey() {
+  if (owns_letters_) {
+    delete[] data_;
+  }
+}
+
+inline MorphKey MorphKey::View(const std::string& letters) noexcept {
+  return View(letters.data(), letters.length());
+}
+
+inline MorphKey MorphKey::Copy(const std::string& letters) {
+  return Copy(letters.data(), letters.length());
+}
+
+} // namespace morfessor
+
+namespace std {
+
+template <>
+struct hash<morfessor::MorphKey> {
+  size_t operator()(const morfessor::MorphKey& key) const noexcept {
+    return static_cast<size_t>(key.hash());
+  }
+};
+
+} // namespace std
+
+#endif /* INCLUDE_MORPH_KEY_H_ */
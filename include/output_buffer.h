@@ -0,0 +1,179 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_OUTPUT_BUFFER_H_
+#define INCLUDE_OUTPUT_BUFFER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iosfwd>
+#include <string>
+#include <utility>
+
+#include "thread_pool.h"
+
+namespace morfessor {
+
+/// How to write large dumps such as the lexicon.
+struct OutputOptions {
+  /// Write the entries sorted by morph, so that the output is the same
+  /// whatever order they are stored in.
+  bool sorted = false;
+
+  /// Number of threads to format the output with. Chunks formatted in
+  /// parallel are still written in order.
+  size_t threads = 1;
+};
+
+/// Writes the decimal digits of a number so that they end just before a
+/// given position.
+/// @param value The number.
+/// @param end One past where the last digit goes. There must be room for
+///   20 digits before it.
+/// @return Where the first digit went.
+char* FormatDecimal(uint64_t value, char* end);
+
+/// Collects text in memory and writes it to a stream in large blocks, with
+/// its own number formatting, instead of going through the formatting of
+/// the stream for every field and flushing on every line.
+class OutputBuffer {
+ public:
+  /// C'tor.
+  /// @param out Where the text goes.
+  /// @param capacity Bytes collected before they are written.
+  explicit OutputBuffer(std::ostream& out, size_t capacity = 1 << 16);
+
+  /// D'tor. Writes what is left.
+  ~OutputBuffer();
+
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  /// Appends bytes.
+  OutputBuffer& Append(const char* data, size_t length);
+
+  /// \overload
+  OutputBuffer& Append(const std::string& text) {
+    return Append(text.data(), text.size());
+  }
+
+  /// Appends one character.
+  OutputBuffer& Append(char c);
+
+  /// Appends a number in decimal.
+  OutputBuffer& AppendUnsigned(uint64_t value);
+
+  /// Appends a number with a fixed number of digits after the point, like
+  /// std::fixed.
+  OutputBuffer& AppendFixed(double value, int precision);
+
+  /// Writes the collected text to the stream and flushes the stream.
+  void Flush();
+
+  /// Returns the stream the text goes to.
+  std::ostream& stream() noexcept { return out_; }
+
+ private:
+  /// Writes the collected text to the stream.
+  void Drain();
+
+  /// Where the text goes.
+  std::ostream& out_;
+
+  /// Text not written yet.
+  std::string buffer_;
+
+  /// Bytes collected before they are written.
+  size_t capacity_;
+};
+
+/// Appends text to an output buffer.
+inline OutputBuffer& operator<<(OutputBuffer& out, const std::string& text) {
+  return out.Append(text);
+}
+
+/// \overload
+inline OutputBuffer& operator<<(OutputBuffer& out, const char* text) {
+  return out.Append(text, std::char_traits<char>::length(text));
+}
+
+/// \overload
+inline OutputBuffer& operator<<(OutputBuffer& out, char c) {
+  return out.Append(c);
+}
+
+/// \overload
+inline OutputBuffer& operator<<(OutputBuffer& out, size_t value) {
+  return out.AppendUnsigned(value);
+}
+
+/// Formats a range of items in chunks and writes the chunks in order. With
+/// more than one thread, the chunks are formatted on a thread pool, a few
+/// per thread at a time, while the finished ones are written.
+/// @param out Where the text goes.
+/// @param count Number of items.
+/// @param format Called with the first and one past the last index of a
+///   chunk and a string to append the text of those items to. Called from
+///   several threads at once if threads > 1.
+/// @param threads Number of threads to format with.
+/// @param chunk_size Number of items per chunk.
+template <class Format>
+void WriteChunks(OutputBuffer& out, size_t count, const Format& format,
+    size_t threads, size_t chunk_size = 4096) {
+  if (threads <= 1 || count <= chunk_size) {
+    std::string text;
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+      text.clear();
+      format(begin, std::min(count, begin + chunk_size), text);
+      out.Append(text);
+    }
+    return;
+  }
+
+  ThreadPool pool{threads};
+  std::deque<std::future<std::string> > pending;
+  auto write_next = [&out, &pending]() {
+    out.Append(pending.front().get());
+    pending.pop_front();
+  };
+  for (size_t begin = 0; begin < count; begin += chunk_size) {
+    if (pending.size() == 2 * pool.size()) {
+      write_next();
+    }
+    auto end = std::min(count, begin + chunk_size);
+    pending.push_back(pool.Submit([&format, begin, end]() {
+      std::string text;
+      format(begin, end, text);
+      return text;
+    }));
+  }
+  while (!pending.empty()) {
+    write_next();
+  }
+}
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_OUTPUT_BUFFER_H_ */
@@ -0,0 +1,103 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_RESTARTS_H_
+#define INCLUDE_RESTARTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+#include "types.h"
+
+namespace morfessor {
+
+/// How a training run started by OptimizeWithRestarts went.
+struct RestartOutcome {
+  /// The seed the run shuffled the morphs with.
+  uint32_t seed = 0;
+
+  /// Number of passes over the lexicon the run completed.
+  size_t epochs = 0;
+
+  /// Overall cost when the run converged or was abandoned.
+  Cost overall_cost = 0;
+
+  /// Whether the run was stopped early because another run was clearly
+  /// ahead of it.
+  bool abandoned = false;
+};
+
+/// The best of several training runs.
+struct RestartResult {
+  /// The model of the best segmentation.
+  std::shared_ptr<Model> model;
+
+  /// The converged segmentation with the lowest overall cost.
+  std::unique_ptr<Segmentation> segmentation;
+
+  /// Index of the best run in outcomes.
+  size_t best = 0;
+
+  /// One entry per run, in the order of their seeds.
+  std::vector<RestartOutcome> outcomes;
+};
+
+/// Makes the model for one training run from letter statistics counted
+/// once for all runs.
+using ModelFactory =
+    std::function<std::shared_ptr<Model>(const LetterStatistics&)>;
+
+/// Optimizes several segmentations of the same corpus, each shuffling the
+/// morphs with its own seed, and keeps the one with the lowest overall
+/// cost.
+///
+/// Runs are compared after every pass over the lexicon. The costs of
+/// different runs stay within a tiny fraction of each other, but late
+/// passes improve the cost very little, so a run that is behind the best
+/// run by more than what the best run gained in the same pass is unlikely
+/// to catch up, and is abandoned. The run that is best after the last pass
+/// is never abandoned, so at least one run always converges. Segmentations are
+/// freed as soon as they are known not to be the best. Which runs get
+/// abandoned can depend on how the threads are scheduled, since a run is
+/// only compared with the runs that got through the same pass before it.
+/// @param corpus The training words, shared by all runs.
+/// @param make_model Makes the model of each run.
+/// @param restarts Number of runs. Must be > 0.
+/// @param seed The seed of the first run. Run i uses seed + i.
+/// @param threads Number of runs to train at once. 0 means one per
+///   hardware thread.
+/// @param margin How many times the best run's gain in a pass a run may
+///   fall behind by before it is abandoned. Pass a negative number to
+///   never abandon runs.
+RestartResult OptimizeWithRestarts(const Corpus& corpus,
+    const ModelFactory& make_model, size_t restarts, uint32_t seed,
+    size_t threads = 0, double margin = 1.0);
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_RESTARTS_H_ */
@@ -23,39 +23,231 @@
 #ifndef INCLUDE_SEGMENTATION_H_
 #define INCLUDE_SEGMENTATION_H_
 
+#include <atomic>
 #include <cmath>
 #include <cassert>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <unordered_map>
 #include <iosfwd>
 #include <memory>
+#include <random>
 #include <vector>
 #include <string>
+#include <utility>
 
+#include "epoch_stats.h"
+#include "instrumentation.h"
+#include "lexicon_snapshot.h"
+#include "memory_usage.h"
 #include "morph.h"
+#include "morph_ids.h"
+#include "morph_key.h"
 #include "model.h"
 #include "types.h"
 #include "morph_node.h"
+#include "output_buffer.h"
+#include "viterbi.h"
 
 namespace morfessor {
 
+/// Which part of the split trees Segmentation::print_dot draws.
+struct DotFilter {
+  /// Draw only these words and the morphs they split into. Empty for every
+  /// word.
+  std::vector<std::string> words;
+
+  /// Leave out the morphs that occur fewer times than this, and what they
+  /// split into.
+  size_t min_count = 0;
+
+  /// Draw at most this many levels of each tree, counting the word as the
+  /// first. 0 for no limit.
+  size_t max_depth = 0;
+
+  /// Returns true if the filter lets every node through.
+  bool empty() const noexcept {
+    return words.empty() && min_count == 0 && max_depth == 0;
+  }
+};
+
 /// Stores recursive segmentations of a set of words.
 class Segmentation {
  public:
+  /// Called at the end of every pass of the optimizer.
+  using EpochCallback = std::function<void(const EpochStats&)>;
+
+  /// Given a morph, returns the length of the left child to split it into,
+  /// or 0 to leave it unsplit.
+  using SplitFunction = std::function<size_t(const std::string&)>;
+
   /// C'tor that initializes the segmentation with every word in the
-  /// training corpus as its own morph.
+  /// training corpus as its own morph. The words are shared with the
+  /// corpus rather than copied.
   /// @param corpus The words in the corpus and their frequencies.
   /// @param model The cost model to use when optimizing the segmentation.
   explicit Segmentation(const Corpus& training_corpus,
       std::shared_ptr<Model> model);
 
+  /// D'tor. Waits for a checkpoint that is still being written.
+  ~Segmentation();
+
+  /// Receives the best segmentation of a test word.
+  /// @param word The word.
+  /// @param boundaries The index one past the end of each morph in the
+  ///   word. Only valid during the call.
+  /// @param morph_count The number of morphs.
+  using BoundarySink = std::function<void(const std::string& word,
+      const size_t* boundaries, size_t morph_count)>;
+
+  /// Receives the best segmentation of a test word as a line without the
+  /// newline, in the format of AppendSegmentation. The line is a buffer
+  /// that is reused for the next word.
+  using LineSink = std::function<void(const std::string& line)>;
+
   /// Returns the best splits for a test corpus given the current segmentation.
   std::shared_ptr<std::vector<std::string> >
   SegmentTestCorpus(const Corpus& test_corpus);
 
+  /// Finds the best segmentation of every word in a test corpus, in order,
+  /// and hands each one to a sink as soon as it is found. Nothing is kept
+  /// between words, so memory does not grow with the size of the corpus.
+  /// @param test_corpus The words to segment.
+  /// @param sink Called once per word.
+  void SegmentTestCorpus(const Corpus& test_corpus,
+      const BoundarySink& sink) const;
+
+  /// \overload
+  void SegmentTestCorpusLines(const Corpus& test_corpus,
+      const LineSink& sink) const;
+
+  /// Returns the best segmentation of a word given the current
+  /// segmentation, found with the Viterbi algorithm.
+  /// @param word The word to segment.
+  /// @return The index one past the end of each morph in the word, in
+  ///   order. The last index is the length of the word.
+  std::vector<size_t> SegmentWord(const std::string& word) const;
+
+  /// Working memory for SegmentWord.
+  using DecodeBuffers = morfessor::DecodeBuffers;
+
+  /// \overload
+  /// @param word The letters of the word to segment.
+  /// @param length The number of letters in the word.
+  /// @param buffers Working memory.
+  /// @param boundaries Receives the index one past the end of each morph.
+  ///   Must have room for length indices.
+  /// @return The number of morphs.
+  size_t SegmentWord(const char* word, size_t length, DecodeBuffers& buffers,
+      size_t* boundaries) const;
+
+  /// Returns the k best segmentations of a word given the current
+  /// segmentation, cheapest first, with their costs. The first one is the
+  /// one SegmentWord returns.
+  /// @param word The word to segment.
+  /// @param k Number of segmentations to return. Must be > 0. Words with
+  ///   fewer segmentations return all of them.
+  std::vector<ScoredSegmentation> SegmentWord(const std::string& word,
+      size_t k) const;
+
+  /// Working memory for the k best SegmentWord.
+  using KBestDecodeBuffers = morfessor::KBestDecodeBuffers;
+
+  /// \overload
+  /// @param word The letters of the word to segment.
+  /// @param length The number of letters in the word.
+  /// @param k Number of segmentations to find. Must be > 0.
+  /// @param buffers Working memory.
+  /// @param paths Receives the segmentations. Its elements are reused.
+  /// @return The number of segmentations.
+  size_t SegmentWord(const char* word, size_t length, size_t k,
+      KBestDecodeBuffers& buffers,
+      std::vector<ScoredSegmentation>& paths) const;
+
+  /// Splits the words in the segmentation the same way as in a previous
+  /// run, instead of starting from every word unsplit. Words and morphs the
+  /// previous run did not know about are left unsplit. Call before
+  /// Optimize.
+  /// @param tree The split trees of the previous run, as written by
+  ///   print_tree.
+  void WarmStart(std::istream& tree);
+
+  /// Splits the words in the segmentation according to their best
+  /// segmentation under a previous model, instead of starting from every
+  /// word unsplit. Call before Optimize.
+  /// @param previous A segmentation built from the previous model.
+  void WarmStart(const Segmentation& previous);
+
   /// Updates the data structure by recursively finding the best split
-  /// for each morph.
+  /// for each morph. If a checkpoint was loaded, continues the checkpointed
+  /// run where it left off instead.
   void Optimize();
 
+  /// Incrementally trains the segmentation on newly arrived words instead
+  /// of retraining from scratch. The letter statistics and costs of the
+  /// model are updated to include the new words, the words are added to
+  /// the data structure, and only those words are resplit.
+  /// @param new_words New words, or frequency increments for words that
+  ///   are already in the segmentation. New words are shared with the
+  ///   corpus rather than copied.
+  void Update(const Corpus& new_words);
+
+  /// Seeds the shuffling of the morphs before every pass over the lexicon,
+  /// so that training gives the same result every time. Unseeded
+  /// segmentations use a random seed.
+  /// @param seed The seed.
+  void set_seed(uint32_t seed);
+
+  /// Makes Optimize or Update return once the morph being resplit is done,
+  /// leaving a consistent segmentation that has not converged yet. Later
+  /// calls return right away. Can be called from any thread, including
+  /// from the epoch callback.
+  void Stop() noexcept;
+
+  /// Sets a function to call with progress information at the end of every
+  /// pass over the lexicon, in both Optimize and Update.
+  /// @param callback The function to call. Pass nullptr to stop reporting.
+  void set_epoch_callback(EpochCallback callback);
+
+  /// Sets where to publish a snapshot of the lexicon at the end of every
+  /// pass over the lexicon, in both Optimize and Update, so that other
+  /// threads can segment words with it while training continues.
+  /// @param publisher The publisher to use. Pass nullptr to stop
+  ///   publishing.
+  void set_snapshot_publisher(std::shared_ptr<SnapshotPublisher> publisher);
+
+  /// Returns a copy of the current lexicon that is cheap to decode with and
+  /// unaffected by further training.
+  std::unique_ptr<const LexiconSnapshot> Snapshot() const;
+
+  /// Returns stable IDs for every morph the decoder can produce, which
+  /// decode words straight to IDs with the same segmentations as
+  /// SegmentWord.
+  std::unique_ptr<const MorphVocabulary> Vocabulary() const;
+
+  /// Makes Optimize and Update save a checkpoint at the end of every few
+  /// passes over the lexicon, as long as training has not converged yet.
+  /// The checkpoint is captured in memory and written to disk in the
+  /// background, replacing the previous one only once it is complete.
+  /// @param path Where to write the checkpoint. Empty to disable.
+  /// @param interval Number of passes between checkpoints. Must be > 0.
+  void set_checkpoint(const std::string& path, size_t interval = 1);
+
+  /// Writes everything needed to continue training exactly where it is now:
+  /// the split trees, the model's accumulators, the random number generator
+  /// and the order of the morphs still being resplit.
+  /// @param out An output stream.
+  void SaveCheckpoint(std::ostream& out) const;
+
+  /// Restores a checkpoint written by SaveCheckpoint. The next call to
+  /// Optimize continues the checkpointed run, and produces the same result
+  /// as the original run would have. The segmentation must have been
+  /// constructed with the same corpus and model parameters.
+  /// @param in An input stream.
+  /// @throw runtime_error if the checkpoint could not be read.
+  void LoadCheckpoint(std::istream& in);
+
   /// Recursively finds the best split for a morph or word. Whereas regular
   /// Split will only split a morph once, and only where you tell it
   /// to, this will find the best way to split the morph, and it will
@@ -64,14 +256,16 @@ class Segmentation {
   /// morphs comprise a word or what the best split is.
   /// @param morph The word or morph to recursively split. Cannot be empty
   ///   string.
-  void ResplitNode(std::string morph);
+  void ResplitNode(const std::string& morph);
 
-  /// Recursively update the morph count for all nodes rooted at a given node.
+  /// Update the morph count for all nodes rooted at a given node.
   /// If the given node does not exist, creates it. The morph count after
-  /// adjusting by delta must never be negative.
+  /// adjusting by delta must never be negative. The tree is walked
+  /// iteratively, and the cost changes of all the leaves in the subtree are
+  /// applied to the model in one batch at the end.
   /// @param morph The morph to adjust the count of. Cannot be empty string.
   /// @param delta The amount to adjust the count by.
-  void AdjustMorphCount(std::string morph, int delta);
+  void AdjustMorphCount(const std::string& morph, int delta);
 
   /// Returns true if the given morph is in the data structure.
   /// @param morph The word or morph to look for.
@@ -85,42 +279,263 @@ class Segmentation {
   /// \overload
   const MorphNode& at(const std::string& morph) const;
 
+  /// Returns the number of nodes in the split trees.
+  size_t size() const noexcept { return nodes_.size(); }
+
+  /// Returns the bytes used by the split trees and the optimizer.
+  MemoryUsage memory_usage() const;
+
   /// Prints the current state of the model.
   /// @param out An output stream.
-  std::ostream& print(std::ostream& out) const;
+  /// @param options Order and threads to format with.
+  std::ostream& print(std::ostream& out,
+      const OutputOptions& options = OutputOptions()) const;
 
   /// Prints the current state of the model, in the expected format for a
-  // corpus.
+  /// corpus.
+  /// @param out An output stream.
+  /// @param options Order and threads to format with.
+  std::ostream& print_as_corpus(std::ostream& out,
+      const OutputOptions& options = OutputOptions()) const;
+
+  /// Prints the split trees, one node per line: the count and the morph,
+  /// followed by its left and right child if it is split.
   /// @param out An output stream.
-  std::ostream& print_as_corpus(std::ostream& out) const;
+  /// @param options Order and threads to format with.
+  std::ostream& print_tree(std::ostream& out,
+      const OutputOptions& options = OutputOptions()) const;
 
   /// Prints the current state of the model as a graphviz dot file.
   /// @param out An output stream.
-  std::ostream& print_dot(std::ostream& out) const;
+  /// @param filter Which nodes to draw.
+  /// @param options Order and threads to format with.
+  std::ostream& print_dot(std::ostream& out,
+      const DotFilter& filter = DotFilter(),
+      const OutputOptions& options = OutputOptions()) const;
 
   /// \overload
   std::ostream& print_dot_debug() const;
 
  private:
+  /// Splits every word in the data structure, recursively, at the point
+  /// given by a split function.
+  /// @param split_index Says where to split each word and morph.
+  void SplitWords(const SplitFunction& split_index);
+
+  /// Splits a morph at the point given by a split function, and recurses
+  /// into the resulting morphs.
+  /// @param morph The morph to split. Cannot be empty string.
+  /// @param split_index Says where to split each word and morph.
+  void SplitNode(const MorphKey& morph, const SplitFunction& split_index);
+
+  /// \overload
+  /// The morphs split off from the morph get keys that view the same
+  /// letters as morph, if it is a view.
+  void ResplitNode(const MorphKey& morph);
+
+  /// \overload
+  /// If the morph is not in the data structure, it is added with a copy of
+  /// the key, so a view must be of letters that outlive the segmentation.
+  void AdjustMorphCount(const MorphKey& morph, int delta);
+
+  /// \overload
+  bool contains(const MorphKey& morph) const;
+
+  /// A node of the split trees, linked to the entries of its children so
+  /// that walking a tree needs no lookups. The links stay valid because a
+  /// child is never erased while it has a parent: its count is at least
+  /// theirs, and a morph that is being resplit keeps its entry.
+  struct TreeNode : MorphNode {
+    using MorphNode::MorphNode;
+
+    /// The entry of the left child. Null if the node is not split.
+    std::pair<const MorphKey, TreeNode>* left_node = nullptr;
+
+    /// The entry of the right child. Null if the node is not split.
+    std::pair<const MorphKey, TreeNode>* right_node = nullptr;
+  };
+
   /// The data structure containing the morphs and their splits.
-  std::unordered_map<std::string, MorphNode> nodes_;
+  using NodeMap = std::unordered_map<MorphKey, TreeNode>;
+
+  /// A morph and its node.
+  using NodeEntry = NodeMap::value_type;
+
+  /// Updates the morph count for all nodes rooted at a node found or just
+  /// added by AdjustMorphCount, and erases the node if its count drops
+  /// to 0.
+  /// @param root The node.
+  /// @param delta The amount to adjust the count by.
+  void AdjustRoot(NodeMap::iterator root, int delta);
+
+  /// Updates the morph count for all nodes rooted at a given node, like
+  /// AdjustMorphCount, except that the node itself is kept even if its
+  /// count drops to 0.
+  /// @param root The node. Its count may only be 0 if delta is positive.
+  /// @param delta The amount to adjust the count by.
+  void AdjustSubtree(NodeEntry& root, int delta);
+
+  /// Takes a node and everything below it out of the model, and erases the
+  /// nodes below it. The node itself is left unsplit with a count of 0, so
+  /// the links of the nodes it is a child of stay valid until its count is
+  /// restored.
+  /// @param entry The node.
+  void DetachNode(NodeEntry& entry);
+
+  /// Links a node to the entries of its children. A link is null if the
+  /// child is not in the data structure.
+  /// @param nodes The data structure the node is in.
+  /// @param node The node.
+  static void LinkChildren(NodeMap& nodes, TreeNode& node);
+
+  /// Returns the nodes to print, in the order to print them in.
+  /// @param leaves_only Leave out the nodes that are split.
+  /// @param sorted Sort the nodes by morph.
+  std::vector<const NodeEntry*> OutputNodes(bool leaves_only,
+      bool sorted) const;
+
+  /// Returns the nodes print_dot draws, in the order to draw them in.
+  /// @param filter Which nodes to draw.
+  /// @param sorted Sort the nodes by morph.
+  std::vector<const NodeEntry*> DotNodes(const DotFilter& filter,
+      bool sorted) const;
+
+  /// Prints one line per leaf: the count and the morph.
+  /// @param out Where the lines go.
+  /// @param options Order and threads to format with.
+  void PrintLeaves(OutputBuffer& out, const OutputOptions& options) const;
+
+  /// Looks up the cost of a morph for decoding.
+  /// @param morph The morph.
+  /// @param log_token_count Log of the number of morph tokens.
+  /// @param cost Receives the cost of the morph.
+  /// @return false if the morph is not in the data structure.
+  bool DecodeCost(const std::string& morph, Cost log_token_count,
+      Cost& cost) const;
+
+  /// Counts the work of decoding a word.
+  /// @param cells Number of morphs looked up.
+  static void CountDecode(uint64_t cells);
+
+  /// Resplits the morphs in keys_ in random order, over and over, until a
+  /// pass no longer improves the overall cost by more than the model's
+  /// convergence threshold.
+  void ResplitUntilConverged();
+
+  /// Captures a checkpoint and starts writing it to checkpoint_path_ in the
+  /// background, after waiting for the previous one to finish.
+  void WriteCheckpointInBackground();
+
+  /// Waits for the checkpoint being written in the background, if any.
+  /// @throw runtime_error if the checkpoint could not be written.
+  void WaitForCheckpoint();
+
+  /// The data structure containing the morphs and their splits. The keys
+  /// of the words, and of the morphs split off from them, view the letters
+  /// in word_storage_. Only morphs that were handed in from outside, such
+  /// as those read from a checkpoint, own their letters.
+  NodeMap nodes_;
+
+  /// The words of the corpora the segmentation was built and updated
+  /// from, kept alive for the keys that view them.
+  std::vector<std::shared_ptr<const std::vector<Morph> > > word_storage_;
 
   /// The probabilistic model that guides the segmentation.
   std::shared_ptr<Model> model_;
+
+  /// Receives progress information during optimization. May be empty.
+  EpochCallback epoch_callback_;
+
+  /// Receives a lexicon snapshot after every pass. May be null.
+  std::shared_ptr<SnapshotPublisher> snapshot_publisher_;
+
+  /// Shuffles the morphs before every pass over the lexicon.
+  std::mt19937 rng_;
+
+  /// Set by Stop.
+  std::atomic<bool> stop_requested_{false};
+
+  /// The morphs being resplit by the current training run, in the order
+  /// they were visited in during the last pass.
+  std::vector<MorphKey> keys_;
+
+  /// Number of passes over keys_ completed by the current training run.
+  size_t epoch_ = 0;
+
+  /// True if a checkpoint was loaded and Optimize should continue it.
+  bool resuming_ = false;
+
+  /// Where to save checkpoints. Empty if checkpoints are disabled.
+  std::string checkpoint_path_;
+
+  /// Number of passes between checkpoints.
+  size_t checkpoint_interval_ = 1;
+
+  /// The checkpoint currently being written in the background.
+  std::future<void> checkpoint_write_;
+
+  /// Nodes still to be visited by AdjustMorphCount. Kept between calls so
+  /// its memory can be reused.
+  std::vector<NodeEntry*> pending_nodes_;
+
+  /// Leaf count changes collected by AdjustMorphCount before they are
+  /// applied to the model. Kept between calls, and never shrunk, so that
+  /// its memory and the memory of its strings can be reused.
+  std::vector<MorphCountChange> leaf_changes_;
 };
 
+inline void Segmentation::set_seed(uint32_t seed) {
+  rng_.seed(seed);
+}
+
+inline void Segmentation::Stop() noexcept {
+  stop_requested_.store(true, std::memory_order_relaxed);
+}
+
+inline void Segmentation::set_epoch_callback(EpochCallback callback) {
+  epoch_callback_ = std::move(callback);
+}
+
+inline void Segmentation::set_snapshot_publisher(
+    std::shared_ptr<SnapshotPublisher> publisher) {
+  snapshot_publisher_ = std::move(publisher);
+}
+
+inline void Segmentation::set_checkpoint(const std::string& path,
+    size_t interval) {
+  assert(interval > 0);
+  checkpoint_path_ = path;
+  checkpoint_interval_ = interval;
+}
+
 inline bool Segmentation::contains(const std::string& morph) const {
+  return contains(MorphKey::View(morph));
+}
+
+inline bool Segmentation::contains(const MorphKey& morph) const {
+  instrumentation::Count(instrumentation::Counter::kNodeLookups);
   return nodes_.find(morph) != nodes_.end();
 }
 
 inline MorphNode& Segmentation::at(const std::string& morph) {
-  return nodes_.at(morph);
+  instrumentation::Count(instrumentation::Counter::kNodeLookups);
+  return nodes_.at(MorphKey::View(morph));
 }
 
 inline const MorphNode& Segmentation::at(const std::string& morph) const {
-  return nodes_.at(morph);
+  instrumentation::Count(instrumentation::Counter::kNodeLookups);
+  return nodes_.at(MorphKey::View(morph));
 }
 
+/// Appends the morphs of a segmented word to a string, each followed by a
+/// space, as in the segmentations written by the morfessor program.
+/// @param word The word.
+/// @param boundaries The index one past the end of each morph in the word.
+/// @param morph_count The number of morphs.
+/// @param out The string to append to.
+void AppendSegmentation(const std::string& word, const size_t* boundaries,
+    size_t morph_count, std::string& out);
+
 /// Outputs the segmentation tree.
 inline std::ostream& operator<<(std::ostream& out,
     const Segmentation& st) {
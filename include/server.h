@@ -0,0 +1,86 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_SERVER_H_
+#define INCLUDE_SERVER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "segmentation.h"
+#include "thread_pool.h"
+
+namespace morfessor {
+
+/// Segments words for clients with a trained model kept in memory, so the
+/// model only has to be loaded once.
+///
+/// Clients send one word per line and get back one line per word, in the
+/// same order and format as the segmentation written by the morfessor
+/// program. Lines are segmented in batches on a pool of worker threads,
+/// and a client can keep sending words while earlier answers are written.
+class SegmentationServer {
+ public:
+  /// C'tor.
+  /// @param segmentation The trained segmentation. It must not change while
+  ///   the server is running.
+  /// @param threads Number of worker threads. 0 means one per hardware
+  ///   thread.
+  /// @param batch_size Maximum number of words segmented by one task.
+  SegmentationServer(const Segmentation& segmentation, size_t threads = 0,
+      size_t batch_size = 256);
+
+  /// Answers words read from one file descriptor on another until the
+  /// input ends or the output is closed. Writes to a socket never raise
+  /// SIGPIPE, but a program serving on a pipe has to ignore SIGPIPE for a
+  /// closed output to end the session instead of the program.
+  /// @param in_fd The file descriptor to read words from.
+  /// @param out_fd The file descriptor to write segmentations to. May be
+  ///   the same as in_fd for a socket.
+  void Serve(int in_fd, int out_fd);
+
+  /// Listens on a Unix domain socket and serves every client that connects
+  /// on its own thread. Never returns normally, so the server has to live
+  /// as long as the program.
+  /// @param path The path of the socket. An existing file there is removed.
+  /// @throws std::system_error if the socket cannot be set up or accepting
+  ///   a connection fails.
+  void ListenUnix(const std::string& path);
+
+  /// Returns the segmentation of a batch of words, one line per word.
+  std::string SegmentBatch(const std::vector<std::string>& words) const;
+
+ private:
+  /// The trained segmentation.
+  const Segmentation& segmentation_;
+
+  /// Workers shared by all clients.
+  ThreadPool pool_;
+
+  /// Maximum number of words segmented by one task.
+  size_t batch_size_;
+};
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_SERVER_H_ */
@@ -0,0 +1,93 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_SWEEP_H_
+#define INCLUDE_SWEEP_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "corpus.h"
+#include "evaluation.h"
+#include "types.h"
+
+namespace morfessor {
+
+/// The algorithm and parameters of one training run in a sweep.
+struct SweepConfiguration {
+  AlgorithmModes mode = AlgorithmModes::kBaseline;
+  double hapax = 0.5;
+  double most_common_length = 7.0;
+  double beta = 1.0;
+};
+
+/// What one training run in a sweep ended up with.
+struct SweepResult {
+  SweepConfiguration configuration;
+  Cost overall_cost = 0;
+  Cost lexicon_cost = 0;
+  Cost corpus_cost = 0;
+  size_t unique_morph_types = 0;
+
+  /// Wall time of the training, in seconds.
+  double seconds = 0;
+
+  /// Whether the segmentation was scored against a gold standard.
+  bool evaluated = false;
+
+  /// Boundary score against the gold standard, if evaluated.
+  BoundaryScore score;
+};
+
+/// Returns every combination of the parameter values, leaving out the ones
+/// that differ only in parameters the mode does not use. The hapax prior
+/// only matters with an explicit frequency cost, and the most common
+/// length and beta only with an explicit length cost.
+std::vector<SweepConfiguration> MakeSweepGrid(
+    const std::vector<AlgorithmModes>& modes,
+    const std::vector<double>& hapaxes,
+    const std::vector<double>& most_common_lengths,
+    const std::vector<double>& betas);
+
+/// Trains a segmentation of the corpus for every configuration, several at
+/// a time. The letters of the corpus are only counted once, and every run
+/// reads the same corpus.
+/// @param threads Number of trainings to run at once. 0 means one per
+///   hardware thread.
+/// @param test_corpus If not null, words to segment with each trained model
+///   and score against the gold standard.
+/// @param gold The gold standard for the test corpus, if any.
+/// @return One result per configuration, in the same order.
+std::vector<SweepResult> Sweep(const Corpus& corpus,
+    const std::vector<SweepConfiguration>& configurations,
+    size_t threads = 0, const Corpus* test_corpus = nullptr,
+    const GoldStandard* gold = nullptr);
+
+/// Writes one line per result, with the parameters, costs and scores in
+/// aligned columns.
+std::ostream& print_table(std::ostream& out,
+    const std::vector<SweepResult>& results);
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_SWEEP_H_ */
@@ -0,0 +1,125 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_SYNTHETIC_CORPUS_H_
+#define INCLUDE_SYNTHETIC_CORPUS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace morfessor {
+
+/// Parameters of a synthetic word list.
+struct SyntheticCorpusOptions {
+  /// Number of distinct words to write.
+  size_t word_types = 10000;
+
+  /// Number of morphs in a generated inventory.
+  size_t morph_types = 1000;
+
+  /// Letters of the generated morphs.
+  std::string alphabet = "abcdefghijklmnopqrstuvwxyz";
+
+  /// Shortest and longest generated morph.
+  size_t min_morph_length = 2;
+  size_t max_morph_length = 6;
+
+  /// Fewest and most morphs in a word, chosen uniformly in between.
+  size_t min_morphs = 1;
+  size_t max_morphs = 4;
+
+  /// Zipf exponent for how often each morph is picked by rank.
+  double morph_exponent = 1.0;
+
+  /// Zipf exponent for the word frequencies by rank.
+  double word_exponent = 1.0;
+
+  /// Frequency of the most common word. Every word occurs at least once.
+  size_t max_count = 100000;
+
+  /// Seed of the random number generator. The same options and seed give
+  /// the same word list.
+  uint64_t seed = 1;
+};
+
+/// Writes word lists with a known segmentation, for measuring how training
+/// scales to vocabularies much larger than the bundled test data.
+///
+/// Words are concatenations of morphs drawn from the inventory with Zipfian
+/// probabilities, so a few morphs are shared by many words. The n-th
+/// distinct word gets the frequency max_count / n^word_exponent. The morphs
+/// a word was built from are its gold standard segmentation, even when the
+/// same letters could also be split another way.
+class SyntheticCorpusGenerator {
+ public:
+  /// C'tor. Makes up an inventory of random, distinct morphs.
+  /// @throws std::invalid_argument if the options are inconsistent or the
+  ///   alphabet has too few letters for morph_types distinct morphs.
+  explicit SyntheticCorpusGenerator(const SyntheticCorpusOptions& options);
+
+  /// C'tor.
+  /// @param morphs The morph inventory, most common first.
+  /// @throws std::invalid_argument if the options are inconsistent or there
+  ///   are no morphs.
+  SyntheticCorpusGenerator(const SyntheticCorpusOptions& options,
+      std::vector<std::string> morphs);
+
+  /// Writes word_types lines of "frequency word", most frequent first.
+  /// @param words Where the word list goes.
+  /// @param gold If not null, where the segmentation of each word goes, one
+  ///   "word<TAB>morph morph" line per word in the Morpho Challenge gold
+  ///   standard format.
+  /// @throws std::runtime_error if the inventory cannot form that many
+  ///   distinct words.
+  void Generate(std::ostream& words, std::ostream* gold);
+
+  /// Returns the morph inventory, most common first.
+  const std::vector<std::string>& morphs() const noexcept { return morphs_; }
+
+ private:
+  /// Checks the options and sets up the morph sampling table.
+  void init();
+
+  /// Returns a uniformly distributed number in [0, 1).
+  double uniform();
+
+  /// Returns a uniformly distributed number in [low, high].
+  size_t uniform(size_t low, size_t high);
+
+  SyntheticCorpusOptions options_;
+  std::vector<std::string> morphs_;
+
+  /// Cumulative Zipfian weight of each morph by rank, for sampling.
+  std::vector<double> cumulative_weights_;
+
+  /// Fully specified by the standard, unlike the distributions, so the
+  /// output is the same with every standard library.
+  std::mt19937_64 random_;
+};
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_SYNTHETIC_CORPUS_H_ */
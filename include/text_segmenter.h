@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_TEXT_SEGMENTER_H_
+#define INCLUDE_TEXT_SEGMENTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "segmentation.h"
+#include "thread_pool.h"
+
+namespace morfessor {
+
+/// What TextSegmenter::Segment did.
+struct TextStats {
+  /// Bytes of text read.
+  size_t bytes = 0;
+
+  /// Tokens segmented.
+  size_t tokens = 0;
+
+  /// Tokens that were not in the cache and had to be decoded.
+  size_t decoded = 0;
+};
+
+/// Segments tokenized running text, such as a corpus with one sentence per
+/// line, instead of a word list.
+///
+/// Tokens are the runs of bytes between whitespace. Each one is replaced by
+/// its morphs joined by a separator, and the whitespace is written out
+/// unchanged, so the output lines up with the input. The text goes through
+/// three stages: a reader cuts it into blocks at whitespace, a pool of
+/// workers segments the blocks, and a writer writes them out in order. At
+/// most a few blocks per worker are in flight at once, so memory does not
+/// grow with the length of the text. Since the same words recur constantly
+/// in running text, the workers share a cache of the segmentations of the
+/// tokens they have seen.
+class TextSegmenter {
+ public:
+  /// C'tor.
+  /// @param segmentation The trained segmentation. It must not change while
+  ///   text is being segmented.
+  /// @param separator Written between the morphs of a token.
+  /// @param threads Number of worker threads. 0 means one per hardware
+  ///   thread.
+  /// @param block_size Bytes of text segmented by one task. Must be > 0.
+  /// @param cache_size Maximum number of distinct tokens to remember.
+  TextSegmenter(const Segmentation& segmentation,
+      const std::string& separator = " + ", size_t threads = 0,
+      size_t block_size = 1 << 20, size_t cache_size = 1 << 20);
+
+  /// D'tor.
+  ~TextSegmenter();
+
+  TextSegmenter(const TextSegmenter&) = delete;
+  TextSegmenter& operator=(const TextSegmenter&) = delete;
+
+  /// Segments the text read from one file descriptor and writes it to
+  /// another. The cache is kept for the next call.
+  /// @param in_fd The file descriptor to read text from.
+  /// @param out_fd The file descriptor to write the segmented text to.
+  /// @return What was done.
+  /// @throws std::system_error if reading or writing fails.
+  TextStats Segment(int in_fd, int out_fd);
+
+  /// Segments a block of text that starts and ends at token boundaries.
+  /// @param text The text.
+  /// @param length The number of bytes of text.
+  /// @param out Receives the segmented text, after what it already holds.
+  /// @return Number of tokens in the text and number of them decoded.
+  std::pair<size_t, size_t> SegmentBlock(const char* text, size_t length,
+      std::string& out);
+
+ private:
+  class Cache;
+
+  /// The trained segmentation.
+  const Segmentation& segmentation_;
+
+  /// Written between the morphs of a token.
+  std::string separator_;
+
+  /// Bytes of text segmented by one task.
+  size_t block_size_;
+
+  /// Segmentations of the tokens seen so far.
+  std::unique_ptr<Cache> cache_;
+
+  /// The workers.
+  ThreadPool pool_;
+};
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_TEXT_SEGMENTER_H_ */
@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_THREAD_POOL_H_
+#define INCLUDE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace morfessor {
+
+/// A fixed number of worker threads that run submitted tasks in the order
+/// they were submitted.
+class ThreadPool {
+ public:
+  /// C'tor that starts the worker threads.
+  /// @param threads Number of worker threads. 0 means one per hardware
+  ///   thread.
+  explicit ThreadPool(size_t threads = 0);
+
+  /// D'tor. Finishes the tasks that were already submitted, then stops the
+  /// worker threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Queues a task to run on one of the worker threads.
+  /// @param task A function taking no arguments.
+  /// @return A future for the result of the task. Exceptions thrown by the
+  ///   task are rethrown when the result is retrieved.
+  template <class Task>
+  auto Submit(Task task) -> std::future<decltype(task())>;
+
+  /// Returns the number of worker threads.
+  size_t size() const noexcept;
+
+ private:
+  /// Runs tasks until the pool is stopped and the queue is empty.
+  void Work();
+
+  /// The worker threads.
+  std::vector<std::thread> workers_;
+
+  /// Tasks waiting for a worker thread.
+  std::queue<std::function<void()> > tasks_;
+
+  /// Guards tasks_ and stopping_.
+  std::mutex mutex_;
+
+  /// Signals the workers when a task is queued or the pool stops.
+  std::condition_variable task_available_;
+
+  /// Set when the pool is being destroyed.
+  bool stopping_ = false;
+};
+
+template <class Task>
+auto ThreadPool::Submit(Task task) -> std::future<decltype(task())> {
+  // std::function has to be copyable, but packaged_task can only be moved.
+  auto packaged = std::make_shared<std::packaged_task<decltype(task())()> >(
+      std::move(task));
+  auto result = packaged->get_future();
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_.emplace([packaged]() { (*packaged)(); });
+  }
+  task_available_.notify_one();
+  return result;
+}
+
+inline size_t ThreadPool::size() const noexcept {
+  return workers_.size();
+}
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_THREAD_POOL_H_ */
@@ -0,0 +1,354 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDE_VITERBI_H_
+#define INCLUDE_VITERBI_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace morfessor {
+
+/// Working memory for decoding words. Reusing one for many words saves
+/// allocating it again for every word. Each thread needs its own.
+struct DecodeBuffers {
+  /// Cost of the best segmentation of each prefix of the word.
+  std::vector<double> delta;
+
+  /// Length of the last morph in the best segmentation of each prefix.
+  std::vector<size_t> psi;
+
+  /// ID of the last morph in the best segmentation of each prefix, when
+  /// IDs are asked for.
+  std::vector<uint32_t> ids;
+
+  /// The morph being looked up.
+  std::string morph;
+};
+
+/// The ID ViterbiIds gives letters that are not known morphs.
+constexpr uint32_t kUnknownMorphId = 0;
+
+/// Finds the cheapest segmentation of a word into known morphs with the
+/// Viterbi algorithm, along with the ID of each morph, so that callers
+/// that only want IDs never have to look the morphs up again. Letters that
+/// are not known morphs become morphs of their own, at a cost higher than
+/// any segmentation into known morphs, and get kUnknownMorphId.
+/// @param word The letters of the word to segment.
+/// @param length The number of letters in the word.
+/// @param log_token_count Log of the number of morph tokens in the
+///   lexicon.
+/// @param max_morph_length No morph in the lexicon is longer than this.
+/// @param morph_cost Called with a morph, a Cost and an ID to fill in.
+///   Returns false if the morph is unknown.
+/// @param buffers Working memory.
+/// @param boundaries Receives the index one past the end of each morph.
+///   Must have room for length indices.
+/// @param ids Receives the ID of each morph, or null if not needed. Must
+///   have room for length IDs.
+/// @return The number of morphs.
+template <class MorphCost>
+size_t ViterbiIds(const char* word, size_t length, Cost log_token_count,
+    size_t max_morph_length, MorphCost&& morph_cost, DecodeBuffers& buffers,
+    size_t* boundaries, uint32_t* ids) {
+  auto word_length = length;
+  // Single letters are always tried, even if the lexicon is empty.
+  auto longest_morph = std::max<size_t>(max_morph_length, 1);
+
+  double bad_likelihood = (word_length + 1) * log_token_count;
+  double pseudo_infinite_cost = (word_length + 1) * bad_likelihood;
+
+  // delta[i] is the cost of the best segmentation of the first i letters,
+  // and psi[i] is the length of the last morph in that segmentation.
+  auto& delta = buffers.delta;
+  auto& psi = buffers.psi;
+  auto& psi_ids = buffers.ids;
+  auto& morph = buffers.morph;
+  delta.assign(word_length + 1, 0.0);
+  psi.assign(word_length + 1, 0);
+  if (ids != nullptr) {
+    psi_ids.assign(word_length + 1, kUnknownMorphId);
+  }
+
+  for (size_t end_index = 1; end_index <= word_length; ++end_index) {
+    double best_delta = pseudo_infinite_cost;
+    size_t best_length = 0;
+    uint32_t best_id = kUnknownMorphId;
+
+    for (size_t morph_length = 1;
+        morph_length <= end_index && morph_length <= longest_morph;
+        ++morph_length) {
+      morph.assign(word + end_index - morph_length, morph_length);
+      Cost cost = 0;
+      uint32_t id = kUnknownMorphId;
+      if (morph_cost(morph, cost, id)) {
+        // Known morph.
+      } else if (morph_length == 1) {
+        // The morph was undefined, and only one letter long. Accept
+        // it with a bad likelihood.
+        cost = bad_likelihood;
+        id = kUnknownMorphId;
+      } else {
+        // The morph was undefined. Keep looking elsewhere.
+        continue;
+      }
+
+      assert(end_index - morph_length < delta.size());
+      double current_delta = delta[end_index - morph_length] + cost;
+      if (current_delta < best_delta) {
+        best_delta = current_delta;
+        best_length = morph_length;
+        best_id = id;
+      }
+    }  // for each morph_length
+
+    assert(end_index < delta.size());
+    delta[end_index] = best_delta;
+    psi[end_index] = best_length;
+    if (ids != nullptr) {
+      psi_ids[end_index] = best_id;
+    }
+  }  // for each end_index
+
+  // Follow the back pointers from the end of the word to the start, once
+  // to count the morphs and once to fill in their ends from the back.
+  size_t morph_count = 0;
+  for (auto end_index = word_length; psi[end_index] != 0;
+      end_index -= psi[end_index]) {
+    ++morph_count;
+  }
+  auto index = morph_count;
+  for (auto end_index = word_length; psi[end_index] != 0;
+      end_index -= psi[end_index]) {
+    assert(end_index > 0 && end_index < psi.size());
+    boundaries[--index] = end_index;
+    if (ids != nullptr) {
+      ids[index] = psi_ids[end_index];
+    }
+  }
+  return morph_count;
+}
+
+/// Finds the cheapest segmentation of a word into known morphs with the
+/// Viterbi algorithm. Letters that are not known morphs become morphs of
+/// their own, at a cost higher than any segmentation into known morphs.
+/// @param word The letters of the word to segment.
+/// @param length The number of letters in the word.
+/// @param log_token_count Log of the number of morph tokens in the
+///   lexicon.
+/// @param max_morph_length No morph in the lexicon is longer than this.
+/// @param morph_cost Called with a morph and a Cost to fill in. Returns
+///   false if the morph is unknown.
+/// @param buffers Working memory.
+/// @param boundaries Receives the index one past the end of each morph.
+///   Must have room for length indices.
+/// @return The number of morphs.
+template <class MorphCost>
+size_t Viterbi(const char* word, size_t length, Cost log_token_count,
+    size_t max_morph_length, MorphCost&& morph_cost, DecodeBuffers& buffers,
+    size_t* boundaries) {
+  return ViterbiIds(word, length, log_token_count, max_morph_length,
+      [&morph_cost](const std::string& morph, Cost& cost, uint32_t&) {
+        return morph_cost(morph, cost);
+      }, buffers, boundaries, nullptr);
+}
+
+/// One of the best segmentations of a word.
+struct ScoredSegmentation {
+  /// Sum of the costs of the morphs.
+  Cost cost = 0;
+
+  /// The index one past the end of each morph in the word, in order.
+  std::vector<size_t> boundaries;
+};
+
+/// Working memory for decoding the k best segmentations of words. Reusing
+/// one for many words saves allocating it again for every word. Each thread
+/// needs its own.
+struct KBestDecodeBuffers {
+  /// One of the best segmentations of a prefix of the word.
+  struct Entry {
+    /// Cost of the segmentation of the prefix.
+    double cost;
+
+    /// Cost of the last morph.
+    double morph_cost;
+
+    /// Length of the last morph, or 0 for the empty prefix.
+    size_t length;
+
+    /// Which of the best segmentations of the rest of the prefix this one
+    /// extends.
+    size_t rank;
+
+    /// Orders entries by cost. Ties go to the shorter last morph, as in
+    /// Viterbi, and then to the better ranked rest of the prefix.
+    bool operator>(const Entry& other) const {
+      return cost != other.cost ? cost > other.cost
+          : length != other.length ? length > other.length
+          : rank > other.rank;
+    }
+  };
+
+  /// The k best segmentations of each prefix, best first, with room for k
+  /// entries per prefix. Prefix i starts at entry i * k.
+  std::vector<Entry> cells;
+
+  /// Number of segmentations found for each prefix.
+  std::vector<size_t> cell_sizes;
+
+  /// Cost of each known morph ending at the current letter, by length.
+  std::vector<std::pair<size_t, Cost> > arcs;
+
+  /// Candidates for the next best segmentation of the current prefix.
+  std::vector<Entry> heap;
+
+  /// The morph being looked up.
+  std::string morph;
+};
+
+/// Finds the k cheapest segmentations of a word into known morphs. Every
+/// prefix keeps its k best segmentations instead of only the best one, and
+/// those of a longer prefix are found by merging the sorted lists of the
+/// shorter prefixes they extend, with a heap holding one candidate per
+/// morph ending there. Each morph is looked up once, as in Viterbi, so the
+/// time grows with k log(max_morph_length) per letter rather than k times
+/// that of Viterbi. The first segmentation is always the one Viterbi
+/// finds.
+/// @param word The letters of the word to segment.
+/// @param length The number of letters in the word.
+/// @param log_token_count Log of the number of morph tokens in the
+///   lexicon.
+/// @param max_morph_length No morph in the lexicon is longer than this.
+/// @param k Number of segmentations to find. Must be > 0.
+/// @param morph_cost Called with a morph and a Cost to fill in. Returns
+///   false if the morph is unknown.
+/// @param buffers Working memory.
+/// @param paths Receives the segmentations, cheapest first. Its elements
+///   are reused. Words with fewer than k segmentations get all of them.
+/// @return The number of segmentations.
+template <class MorphCost>
+size_t KBestViterbi(const char* word, size_t length, Cost log_token_count,
+    size_t max_morph_length, size_t k, MorphCost&& morph_cost,
+    KBestDecodeBuffers& buffers, std::vector<ScoredSegmentation>& paths) {
+  using Entry = KBestDecodeBuffers::Entry;
+  assert(k > 0);
+  auto word_length = length;
+  auto longest_morph = std::max<size_t>(max_morph_length, 1);
+  double bad_likelihood = (word_length + 1) * log_token_count;
+
+  auto& cells = buffers.cells;
+  auto& cell_sizes = buffers.cell_sizes;
+  auto& arcs = buffers.arcs;
+  auto& heap = buffers.heap;
+  auto& morph = buffers.morph;
+  cells.resize((word_length + 1) * k);
+  cell_sizes.assign(word_length + 1, 0);
+  cells[0] = Entry{0.0, 0.0, 0, 0};
+  cell_sizes[0] = 1;
+
+  for (size_t end_index = 1; end_index <= word_length; ++end_index) {
+    // Same lookups as Viterbi.
+    arcs.clear();
+    for (size_t morph_length = 1;
+        morph_length <= end_index && morph_length <= longest_morph;
+        ++morph_length) {
+      morph.assign(word + end_index - morph_length, morph_length);
+      Cost cost = 0;
+      if (morph_cost(morph, cost)) {
+        arcs.emplace_back(morph_length, cost);
+      } else if (morph_length == 1) {
+        arcs.emplace_back(morph_length, bad_likelihood);
+      }
+    }
+
+    // Each morph extends the best segmentation of the rest of the prefix
+    // first. When a candidate is taken, the same morph extending the next
+    // best segmentation of the rest takes its place.
+    heap.clear();
+    for (const auto& arc : arcs) {
+      heap.push_back(Entry{cells[(end_index - arc.first) * k].cost +
+          arc.second, arc.second, arc.first, 0});
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    auto cell = cells.begin() + end_index * k;
+    auto& cell_size = cell_sizes[end_index];
+    while (!heap.empty() && cell_size < k) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+      auto entry = heap.back();
+      heap.pop_back();
+      cell[cell_size++] = entry;
+
+      auto start_index = end_index - entry.length;
+      if (entry.rank + 1 < cell_sizes[start_index]) {
+        const auto& next = cells[start_index * k + entry.rank + 1];
+        heap.push_back(Entry{next.cost + entry.morph_cost, entry.morph_cost,
+            entry.length, entry.rank + 1});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+      }
+    }
+  }  // for each end_index
+
+  // Follow the back pointers of each segmentation of the whole word, once
+  // to count the morphs and once to fill in their ends from the back.
+  auto count = cell_sizes[word_length];
+  if (paths.size() < count) {
+    paths.resize(count);
+  }
+  for (size_t path = 0; path < count; ++path) {
+    paths[path].cost = cells[word_length * k + path].cost;
+    auto& boundaries = paths[path].boundaries;
+
+    size_t morph_count = 0;
+    for (auto end_index = word_length, rank = path;
+        cells[end_index * k + rank].length != 0;) {
+      const auto& step = cells[end_index * k + rank];
+      end_index -= step.length;
+      rank = step.rank;
+      ++morph_count;
+    }
+    boundaries.resize(morph_count);
+    auto index = morph_count;
+    for (auto end_index = word_length, rank = path;
+        cells[end_index * k + rank].length != 0;) {
+      const auto& step = cells[end_index * k + rank];
+      boundaries[--index] = end_index;
+      end_index -= step.length;
+      rank = step.rank;
+    }
+  }
+  return count;
+}
+
+}  // namespace morfessor
+
+#endif /* INCLUDE_VITERBI_H_ */
@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+
+# The MIT License (MIT)
+#
+# Copyright (c) 2016 Derek Felson
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Runs the C++ program and the Perl reference side by side.
+
+For every Morpho Challenge 2005 language with a word list under the data
+directory, both implementations train a model, segment the test set, and
+have their segmentation scored by morpho-challenge-eval.perl. The wall time,
+peak memory, final overall cost and boundary F-measure of each are printed in
+a table. The exit status is 1 when the C++ program is worse than the
+reference (or than a saved --baseline run) by more than the tolerances.
+
+Run it from the scripts directory, like evaluate.sh:
+
+    ./compare-reference.py --languages english,finnish,turkish
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+WORDLIST = "morpho-challenge-2005-wordlist-{}.txt"
+TESTSET = "morpho-challenge-2005-testset-{}.txt"
+GOLDSTD = "morpho-challenge-2005-goldstd-{}.txt"
+
+# The Morpho Challenge files are UTF-8, but the programs work on bytes and
+# may split a character in two. Latin-1 reads and writes any byte unchanged.
+ENCODING = "latin-1"
+
+
+class Run(object):
+    """Measurements of one implementation on one language."""
+
+    def __init__(self):
+        self.seconds = 0.0
+        self.peak_rss = 0
+        self.overall_cost = None
+        self.fmeasure = None
+        self.precision = None
+        self.recall = None
+
+    def to_json(self):
+        return dict(self.__dict__)
+
+    @staticmethod
+    def from_json(values):
+        run = Run()
+        run.__dict__.update(values)
+        return run
+
+
+def run_measured(args, stdout_path, run):
+    """Runs a command with its output in a file, adding its wall time and
+    peak resident set size to the run."""
+    with open(stdout_path, "w") as out:
+        start = time.monotonic()
+        process = subprocess.Popen(args, stdout=out)
+        # wait4 gives the resource usage of this child alone.
+        _, status, usage = os.wait4(process.pid, 0)
+        run.seconds += time.monotonic() - start
+    process.returncode = os.waitstatus_to_exitcode(status)
+    if process.returncode != 0:
+        raise RuntimeError("{} exited with status {}".format(
+            " ".join(args), process.returncode))
+    # ru_maxrss is in kilobytes on Linux.
+    run.peak_rss = max(run.peak_rss, usage.ru_maxrss * 1024)
+
+
+def score(evalscript, goldstd, segmentation, run):
+    """Scores a segmentation with the Morpho Challenge evaluation script."""
+    output = subprocess.check_output(
+        [evalscript, "-desired", goldstd, "-suggested", segmentation],
+        universal_newlines=True, encoding=ENCODING)
+    for name in ("F-measure", "Precision", "Recall"):
+        match = re.search(r"^{}:\s+([0-9.]+)%".format(name), output, re.M)
+        if not match:
+            raise RuntimeError("no {} in the output of {}".format(
+                name, evalscript))
+        setattr(run, name.lower().replace("-", ""), float(match.group(1)))
+
+
+def run_cpp(options, language, outdir):
+    run = Run()
+    model = os.path.join(outdir, "model.txt")
+    segmentation = os.path.join(outdir, "test-segmentation.txt")
+    mode = options.cpp_args.split()
+    run_measured([options.morfessor] + mode + ["--data",
+        os.path.join(options.data_dir, WORDLIST.format(language))],
+        model, run)
+    run_measured([options.morfessor] + mode + ["--load", model, "--data",
+        os.path.join(options.data_dir, TESTSET.format(language))],
+        segmentation, run)
+    with open(model, encoding=ENCODING) as lines:
+        match = re.match(r"Overall cost: ([0-9.]+)", lines.readline())
+        run.overall_cost = float(match.group(1)) if match else None
+    score(options.eval, os.path.join(options.data_dir,
+        GOLDSTD.format(language)), segmentation, run)
+    return run
+
+
+def run_reference(options, language, outdir):
+    run = Run()
+    model = os.path.join(outdir, "model.txt")
+    raw = os.path.join(outdir, "test-segmentation.raw.txt")
+    segmentation = os.path.join(outdir, "test-segmentation.txt")
+    # Trace level 2 writes the cost after each pass as comments in the model.
+    run_measured([options.reference, "-trace", "2", "-data",
+        os.path.join(options.data_dir, WORDLIST.format(language))],
+        model, run)
+    run_measured([options.reference, "-load", model, "-data",
+        os.path.join(options.data_dir, TESTSET.format(language))],
+        raw, run)
+    with open(model, encoding=ENCODING) as lines:
+        costs = re.findall(r"^# OVERALL logprob: ([0-9.]+)", lines.read(),
+            re.M)
+        run.overall_cost = float(costs[-1]) if costs else None
+    # Same clean-up as evaluate_ref in evaluate.sh.
+    with open(raw, encoding=ENCODING) as lines, \
+            open(segmentation, "w", encoding=ENCODING) as out:
+        for line in lines:
+            if line.startswith("#"):
+                continue
+            out.write(re.sub(r"^1 ", "", line).replace(" + ", " "))
+    score(options.eval, os.path.join(options.data_dir,
+        GOLDSTD.format(language)), segmentation, run)
+    return run
+
+
+def regressions(language, cpp, reference, baseline, options):
+    """Returns a description of each way the C++ run is worse than allowed."""
+    found = []
+    def check(bad, message):
+        if bad:
+            found.append("{}: {}".format(language, message))
+    if cpp.overall_cost is not None and reference.overall_cost is not None:
+        limit = reference.overall_cost * (1 + options.cost_tolerance)
+        check(cpp.overall_cost > limit,
+            "overall cost {:.1f} is above the reference {:.1f}".format(
+                cpp.overall_cost, reference.overall_cost))
+    check(cpp.fmeasure < reference.fmeasure - options.fmeasure_tolerance,
+        "F-measure {:.2f}% is below the reference {:.2f}%".format(
+            cpp.fmeasure, reference.fmeasure))
+    check(cpp.seconds > reference.seconds * options.time_tolerance,
+        "{:.1f} s is slower than the reference {:.1f} s".format(
+            cpp.seconds, reference.seconds))
+    check(cpp.peak_rss > reference.peak_rss * options.memory_tolerance,
+        "{} bytes peak RSS is above the reference {}".format(
+            cpp.peak_rss, reference.peak_rss))
+    if baseline:
+        check(cpp.seconds > baseline.seconds * options.time_tolerance,
+            "{:.1f} s is slower than the baseline {:.1f} s".format(
+                cpp.seconds, baseline.seconds))
+        check(cpp.peak_rss > baseline.peak_rss * options.memory_tolerance,
+            "{} bytes peak RSS is above the baseline {}".format(
+                cpp.peak_rss, baseline.peak_rss))
+        check(cpp.fmeasure < baseline.fmeasure - options.fmeasure_tolerance,
+            "F-measure {:.2f}% is below the baseline {:.2f}%".format(
+                cpp.fmeasure, baseline.fmeasure))
+    return found
+
+
+def print_table(out, results):
+    out.write("{:<10} {:<10} {:>10} {:>14} {:>16} {:>10} {:>10} {:>10}\n"
+        .format("language", "program", "seconds", "peak_rss",
+            "overall_cost", "F", "precision", "recall"))
+    for language, runs in results:
+        for program, run in (("c++", runs["c++"]),
+                ("reference", runs["reference"])):
+            cost = ("{:.3f}".format(run.overall_cost)
+                if run.overall_cost is not None else "-")
+            out.write("{:<10} {:<10} {:>10.2f} {:>14} {:>16} {:>9.2f}% "
+                "{:>9.2f}% {:>9.2f}%\n".format(language, program,
+                    run.seconds, run.peak_rss, cost, run.fmeasure,
+                    run.precision, run.recall))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--languages", default="english,finnish,turkish",
+        help="comma separated languages to compare")
+    parser.add_argument("--data-dir",
+        default=os.path.join(SCRIPT_DIR, "..", "testdata"),
+        help="directory with the Morpho Challenge 2005 files")
+    parser.add_argument("--morfessor",
+        default=os.path.join(SCRIPT_DIR, "..", "build", "morfessor"),
+        help="C++ program to measure")
+    parser.add_argument("--cpp-args", default="--mode Baseline",
+        help="extra arguments for the C++ program")
+    parser.add_argument("--reference",
+        default=os.path.join(SCRIPT_DIR, "morfessor-reference.perl"))
+    parser.add_argument("--eval",
+        default=os.path.join(SCRIPT_DIR, "morpho-challenge-eval.perl"))
+    parser.add_argument("--outdir", default="results/compare-reference",
+        help="where the models and segmentations are written")
+    parser.add_argument("--cost-tolerance", type=float, default=0.01,
+        help="allowed relative excess of the final overall cost")
+    parser.add_argument("--fmeasure-tolerance", type=float, default=1.0,
+        help="allowed drop in F-measure, in percentage points")
+    parser.add_argument("--time-tolerance", type=float, default=1.0,
+        help="allowed ratio of C++ wall time to the comparison run")
+    parser.add_argument("--memory-tolerance", type=float, default=1.0,
+        help="allowed ratio of C++ peak memory to the comparison run")
+    parser.add_argument("--baseline",
+        help="JSON results of an earlier run to also compare against")
+    parser.add_argument("--save", help="write the results as JSON here")
+    options = parser.parse_args()
+
+    baselines = {}
+    if options.baseline:
+        with open(options.baseline) as saved:
+            baselines = json.load(saved)
+
+    results = []
+    for language in options.languages.split(","):
+        wordlist = os.path.join(options.data_dir, WORDLIST.format(language))
+        if not os.path.exists(wordlist):
+            # Only the English word list ships with the repository.
+            sys.stderr.write("skipping {}: no {}\n".format(language,
+                wordlist))
+            continue
+        runs = {}
+        for program, runner in (("c++", run_cpp),
+                ("reference", run_reference)):
+            outdir = os.path.join(options.outdir, language, program)
+            os.makedirs(outdir, exist_ok=True)
+            runs[program] = runner(options, language, outdir)
+        results.append((language, runs))
+
+    print_table(sys.stdout, results)
+
+    if options.save:
+        with open(options.save, "w") as saved:
+            json.dump({language: runs["c++"].to_json()
+                for language, runs in results}, saved, indent=2)
+
+    failures = []
+    for language, runs in results:
+        baseline = baselines.get(language)
+        failures += regressions(language, runs["c++"], runs["reference"],
+            Run.from_json(baseline) if baseline else None, options)
+    for failure in failures:
+        sys.stderr.write("regression: {}\n".format(failure))
+    return 1 if failures or not results else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -23,20 +23,25 @@
 #include "corpus.h"
 
 #include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <fstream>
-#include <sstream>
+#include <utility>
 
 #include "morph.h"
 
 namespace morfessor
 {
 
-Corpus::Corpus(std::istream& in) {
+Corpus::Corpus(std::istream& in)
+: words_{std::make_shared<std::vector<Morph> >()}
+{
   init(in);
 }
 
 Corpus::Corpus(std::string word_file)
-: words_{}
+: words_{std::make_shared<std::vector<Morph> >()}
 {
 	std::ifstream file{word_file};
 	assert(file.is_open());
@@ -44,16 +49,43 @@ Corpus::Corpus(std::string word_file)
 }
 
 void Corpus::init(std::istream& in) {
+  // The line is parsed in place, so the only allocation per word is the
+  // string the Morph keeps.
   std::string line;
   while (getline(in, line))
   {
-    std::stringstream ssline{line};
-    size_t freq;
-    std::string morph_string;
-    ssline >> freq;
-    ssline >> morph_string;
-    words_.emplace_back(morph_string, freq);
+    auto is_space = [](char c) {
+      return std::isspace(static_cast<unsigned char>(c)) != 0;
+    };
+    const char* start = line.c_str();
+    char* number_end;
+    errno = 0;
+    auto freq = std::strtoull(start, &number_end, 10);
+    auto word = number_end;
+    while (is_space(*word)) {
+      ++word;
+    }
+    auto word_end = word;
+    while (*word_end != '\0' && !is_space(*word_end)) {
+      ++word_end;
+    }
+    // Skip anything that is not a frequency followed by a word, such as
+    // the overall cost printed at the top of a saved model.
+    if (number_end != start && errno != ERANGE && word_end != word) {
+      words_->emplace_back(std::string(word, word_end), freq);
+    }
+  }
+}
+
+MemoryUsage Corpus::memory_usage() const {
+  size_t string_bytes = 0;
+  for (const auto& word : *words_) {
+    string_bytes += heap_bytes(word.letters());
   }
+  return MemoryUsage{{
+    {"words", words_->capacity() * sizeof(Morph)},
+    {"word_strings", string_bytes}
+  }};
 }
 
 } // namespace morfessor
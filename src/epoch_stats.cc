@@ -0,0 +1,52 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "epoch_stats.h"
+
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+namespace morfessor {
+
+std::ostream& print_json(std::ostream& out, const EpochStats& stats) {
+  auto old_flags = out.flags();
+  auto old_precision = out.precision(
+      std::numeric_limits<double>::digits10);
+  out.unsetf(std::ios::floatfield);
+  out << "{\"epoch\":" << stats.epoch
+      << ",\"overall_cost\":" << stats.overall_cost
+      << ",\"lexicon_cost\":" << stats.lexicon_cost
+      << ",\"corpus_cost\":" << stats.corpus_cost
+      << ",\"cost_delta\":" << stats.cost_delta
+      << ",\"convergence_threshold\":" << stats.convergence_threshold
+      << ",\"unique_morph_types\":" << stats.unique_morph_types
+      << ",\"total_morph_tokens\":" << stats.total_morph_tokens
+      << ",\"words_resplit\":" << stats.words_resplit
+      << ",\"words_per_second\":" << stats.words_per_second()
+      << ",\"seconds\":" << stats.seconds << "}";
+  out.precision(old_precision);
+  out.flags(old_flags);
+  return out;
+}
+
+}  // namespace morfessor
@@ -0,0 +1,253 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "evaluation.h"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "thread_pool.h"
+
+namespace morfessor {
+
+namespace {
+
+/// Words segmented by one task in Evaluate.
+constexpr size_t kWordsPerTask = 1024;
+
+}  // namespace
+
+double BoundaryScore::precision() const noexcept {
+  if (hits + insertions == 0) {
+    return 1;
+  }
+  return static_cast<double>(hits) / (hits + insertions);
+}
+
+double BoundaryScore::recall() const noexcept {
+  if (hits + deletions == 0) {
+    return 1;
+  }
+  return static_cast<double>(hits) / (hits + deletions);
+}
+
+double BoundaryScore::fmeasure() const noexcept {
+  if (hits + insertions + deletions == 0) {
+    return 1;
+  }
+  return 2.0 * hits / (2 * hits + insertions + deletions);
+}
+
+BoundaryScore& BoundaryScore::operator+=(const BoundaryScore& other)
+    noexcept {
+  hits += other.hits;
+  insertions += other.insertions;
+  deletions += other.deletions;
+  evaluated_words += other.evaluated_words;
+  segmented_words += other.segmented_words;
+  return *this;
+}
+
+GoldStandard::GoldStandard(std::istream& in)
+: analyses_{}
+{
+  init(in);
+}
+
+GoldStandard::GoldStandard(const std::string& gold_file)
+: analyses_{}
+{
+  std::ifstream file{gold_file};
+  if (!file.is_open()) {
+    throw std::runtime_error("cannot open " + gold_file);
+  }
+  init(file);
+}
+
+void GoldStandard::init(std::istream& in) {
+  std::string line;
+  size_t line_number = 0;
+  while (getline(in, line)) {
+    ++line_number;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    auto tab = line.find('\t');
+    if (tab == 0 || tab == std::string::npos || tab + 1 == line.size() ||
+        line.find('\t', tab + 1) != std::string::npos) {
+      throw std::runtime_error("invalid gold standard line " +
+          std::to_string(line_number));
+    }
+    auto word = line.substr(0, tab);
+    auto& alternatives = analyses_[word];
+    alternatives.clear();
+
+    // Alternatives are separated by ", " and morphs by spaces.
+    size_t start = tab + 1;
+    while (start <= line.size()) {
+      auto end = line.find(", ", start);
+      if (end == std::string::npos) {
+        end = line.size();
+      }
+      std::vector<size_t> boundaries;
+      size_t letters = 0;
+      auto spelled = true;
+      for (auto i = start; i < end; ++i) {
+        if (line[i] != ' ') {
+          spelled = spelled && letters < word.size() &&
+              line[i] == word[letters];
+          ++letters;
+        } else if (letters > 0) {
+          boundaries.push_back(letters);
+        }
+      }
+      if (!spelled || letters != word.size()) {
+        throw std::runtime_error("analysis does not spell the word on gold "
+            "standard line " + std::to_string(line_number));
+      }
+      // Trailing spaces do not make a boundary.
+      while (!boundaries.empty() && boundaries.back() == letters) {
+        boundaries.pop_back();
+      }
+      alternatives.push_back(std::move(boundaries));
+      start = end + 2;
+    }
+  }
+}
+
+BoundaryScore GoldStandard::Score(const std::string& word,
+    const size_t* boundaries, size_t morph_count) const {
+  BoundaryScore best;
+  best.segmented_words = 1;
+  auto iter = analyses_.find(word);
+  if (iter == analyses_.end()) {
+    return best;
+  }
+  best.evaluated_words = 1;
+
+  // The last boundary is the end of the word.
+  auto suggested_count = morph_count > 0 ? morph_count - 1 : 0;
+  double best_fmeasure = 0;
+  double best_precision = 0;
+  for (const auto& desired : iter->second) {
+    BoundaryScore score;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < desired.size() && j < suggested_count) {
+      if (desired[i] == boundaries[j]) {
+        ++score.hits;
+        ++i;
+        ++j;
+      } else if (desired[i] < boundaries[j]) {
+        ++score.deletions;
+        ++i;
+      } else {
+        ++score.insertions;
+        ++j;
+      }
+    }
+    score.deletions += desired.size() - i;
+    score.insertions += suggested_count - j;
+
+    // Like the Perl script, prefer the better F-measure, then the better
+    // precision, then the later alternative.
+    auto fmeasure = score.fmeasure();
+    auto precision = score.precision();
+    if (fmeasure > best_fmeasure ||
+        (fmeasure == best_fmeasure && precision >= best_precision)) {
+      best_fmeasure = fmeasure;
+      best_precision = precision;
+      best.hits = score.hits;
+      best.insertions = score.insertions;
+      best.deletions = score.deletions;
+    }
+  }
+  return best;
+}
+
+BoundaryScore GoldStandard::Score(const std::string& segmented_word) const {
+  std::string word;
+  std::vector<size_t> boundaries;
+  std::istringstream morphs{segmented_word};
+  std::string morph;
+  while (morphs >> morph) {
+    word += morph;
+    boundaries.push_back(word.size());
+  }
+  return Score(word, boundaries.data(), boundaries.size());
+}
+
+BoundaryScore Evaluate(const Segmentation& segmentation,
+    const Corpus& test_corpus, const GoldStandard& gold, size_t threads) {
+  ThreadPool pool{threads};
+  std::vector<std::future<BoundaryScore> > scores;
+  for (auto first = test_corpus.cbegin(); first != test_corpus.cend(); ) {
+    auto last = first + std::min<size_t>(kWordsPerTask,
+        test_corpus.cend() - first);
+    scores.push_back(pool.Submit([&segmentation, &gold, first, last]() {
+      BoundaryScore score;
+      Segmentation::DecodeBuffers buffers;
+      std::vector<size_t> boundaries;
+      for (auto iter = first; iter != last; ++iter) {
+        const auto& word = iter->letters();
+        if (boundaries.size() < word.length()) {
+          boundaries.resize(word.length());
+        }
+        auto morph_count = segmentation.SegmentWord(word.data(),
+            word.length(), buffers, boundaries.data());
+        score += gold.Score(word, boundaries.data(), morph_count);
+      }
+      return score;
+    }));
+    first = last;
+  }
+  BoundaryScore total;
+  for (auto& score : scores) {
+    total += score.get();
+  }
+  return total;
+}
+
+std::ostream& print_table(std::ostream& out, const BoundaryScore& score) {
+  auto old_flags = out.flags();
+  auto old_precision = out.precision(2);
+  out << std::fixed;
+  out << "Number of words in data set: " << score.segmented_words
+      << " (type count)\n";
+  out << "Number of words evaluated: " << score.evaluated_words << " ("
+      << (score.segmented_words > 0
+          ? 100.0 * score.evaluated_words / score.segmented_words : 0.0)
+      << "% of all words in data set)\n";
+  out << "Morpheme boundary detections statistics:\n";
+  out << "F-measure:  " << 100 * score.fmeasure() << "%\n";
+  out << "Precision:  " << 100 * score.precision() << "%\n";
+  out << "Recall:     " << 100 * score.recall() << "%\n";
+  out.precision(old_precision);
+  out.flags(old_flags);
+  return out;
+}
+
+}  // namespace morfessor
@@ -0,0 +1,182 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "instrumentation.h"
+
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace morfessor {
+
+namespace instrumentation {
+
+namespace detail {
+
+std::atomic<bool> enabled{false};
+std::atomic<uint64_t> counters[static_cast<size_t>(Counter::kCount)];
+
+}  // namespace detail
+
+namespace {
+
+constexpr size_t kPhaseCount = static_cast<size_t>(Phase::kCount);
+
+// Nanoseconds spent in each phase.
+std::atomic<uint64_t> phase_times[kPhaseCount];
+
+const char* const kCounterNames[] = {
+  "adjust_morph_count_calls",
+  "adjust_morph_count_nodes",
+  "adjust_morph_count_max_stack",
+  "node_lookups",
+  "node_inserts",
+  "node_erases",
+  "resplit_node_calls",
+  "split_candidates",
+  "viterbi_words",
+  "viterbi_cells"
+};
+
+const char* const kPhaseNames[] = {
+  "load",
+  "model_init",
+  "optimize",
+  "output"
+};
+
+double ratio(Counter numerator, Counter denominator) {
+  auto divisor = value(denominator);
+  return divisor == 0 ? 0 : static_cast<double>(value(numerator)) / divisor;
+}
+
+// Everything that is printed, as name and value pairs.
+std::vector<std::pair<std::string, double> > Report() {
+  std::vector<std::pair<std::string, double> > report;
+  for (size_t i = 0; i < static_cast<size_t>(Counter::kCount); ++i) {
+    report.emplace_back(kCounterNames[i],
+        value(static_cast<Counter>(i)));
+  }
+  report.emplace_back("nodes_per_adjust_morph_count", ratio(
+      Counter::kAdjustMorphCountNodes, Counter::kAdjustMorphCountCalls));
+  report.emplace_back("split_candidates_per_resplit_node", ratio(
+      Counter::kSplitCandidates, Counter::kResplitNodeCalls));
+  report.emplace_back("viterbi_cells_per_word", ratio(
+      Counter::kViterbiCells, Counter::kViterbiWords));
+  for (size_t i = 0; i < kPhaseCount; ++i) {
+    report.emplace_back(std::string(kPhaseNames[i]) + "_seconds",
+        seconds(static_cast<Phase>(i)));
+  }
+  return report;
+}
+
+}  // namespace
+
+void Enable(bool enable) {
+  detail::enabled.store(enable);
+}
+
+void CountMax(Counter counter, uint64_t value) {
+  if (!enabled()) {
+    return;
+  }
+  auto& maximum = detail::counters[static_cast<size_t>(counter)];
+  auto current = maximum.load(std::memory_order_relaxed);
+  while (current < value && !maximum.compare_exchange_weak(current, value,
+      std::memory_order_relaxed)) {
+  }
+}
+
+void AddTime(Phase phase, std::chrono::steady_clock::duration time) {
+  if (enabled()) {
+    phase_times[static_cast<size_t>(phase)].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+        std::memory_order_relaxed);
+  }
+}
+
+uint64_t value(Counter counter) {
+  return detail::counters[static_cast<size_t>(counter)].load();
+}
+
+double seconds(Phase phase) {
+  return phase_times[static_cast<size_t>(phase)].load() / 1e9;
+}
+
+void Reset() {
+  for (auto& counter : detail::counters) {
+    counter.store(0);
+  }
+  for (auto& time : phase_times) {
+    time.store(0);
+  }
+}
+
+PhaseTimer::PhaseTimer(Phase phase)
+    : phase_(phase), start_(std::chrono::steady_clock::now()) {
+}
+
+PhaseTimer::~PhaseTimer() {
+  AddTime(phase_, std::chrono::steady_clock::now() - start_);
+}
+
+void PhaseTimer::Switch(Phase phase) {
+  auto now = std::chrono::steady_clock::now();
+  AddTime(phase_, now - start_);
+  phase_ = phase;
+  start_ = now;
+}
+
+std::ostream& print_table(std::ostream& out) {
+  auto old_flags = out.flags();
+  auto old_precision = out.precision(10);
+  for (const auto& entry : Report()) {
+    out << std::left << std::setw(36) << entry.first
+        << std::right << std::setw(18) << entry.second << "\n";
+  }
+  out.precision(old_precision);
+  out.flags(old_flags);
+  return out;
+}
+
+std::ostream& print_json(std::ostream& out) {
+  auto old_flags = out.flags();
+  auto old_precision = out.precision(
+      std::numeric_limits<double>::digits10);
+  out.unsetf(std::ios::floatfield);
+  auto separator = "{";
+  for (const auto& entry : Report()) {
+    out << separator << "\"" << entry.first << "\":" << entry.second;
+    separator = ",";
+  }
+  out << "}";
+  out.precision(old_precision);
+  out.flags(old_flags);
+  return out;
+}
+
+}  // namespace instrumentation
+
+}  // namespace morfessor
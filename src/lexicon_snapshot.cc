@@ -0,0 +1,161 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lexicon_snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace morfessor {
+
+LexiconSnapshot::LexiconSnapshot(
+    std::unordered_map<std::string, Cost> morph_costs,
+    Cost log_token_count, size_t epoch)
+    : morph_costs_(std::move(morph_costs)),
+      log_token_count_(log_token_count), epoch_(epoch) {
+  for (const auto& morph : morph_costs_) {
+    max_morph_length_ = std::max(max_morph_length_, morph.first.length());
+  }
+}
+
+std::vector<size_t> LexiconSnapshot::SegmentWord(
+    const std::string& word) const {
+  DecodeBuffers buffers;
+  std::vector<size_t> boundaries(word.length());
+  boundaries.resize(
+      SegmentWord(word.data(), word.length(), buffers, boundaries.data()));
+  return boundaries;
+}
+
+size_t LexiconSnapshot::SegmentWord(const char* word, size_t length,
+    DecodeBuffers& buffers, size_t* boundaries) const {
+  return Viterbi(word, length, log_token_count_, max_morph_length_,
+      [this](const std::string& morph, Cost& cost) {
+        auto found = morph_costs_.find(morph);
+        if (found == morph_costs_.end()) {
+          return false;
+        }
+        cost = found->second;
+        return true;
+      }, buffers, boundaries);
+}
+
+SnapshotPublisher::Reader::Reader(SnapshotPublisher& publisher)
+    : publisher_(publisher), slot_(publisher.slot_count_) {
+  for (size_t i = 0; i < publisher_.slot_count_; ++i) {
+    auto in_use = false;
+    if (publisher_.slots_[i].in_use.compare_exchange_strong(in_use, true)) {
+      slot_ = i;
+      return;
+    }
+  }
+  throw std::runtime_error("too many snapshot readers");
+}
+
+SnapshotPublisher::Reader::~Reader() {
+  Release();
+  publisher_.slots_[slot_].in_use.store(false);
+}
+
+const LexiconSnapshot* SnapshotPublisher::Reader::Acquire() {
+  // Announce the epoch before loading the snapshot, so that a publisher
+  // that replaces the snapshot afterwards knows to keep it.
+  publisher_.slots_[slot_].epoch.store(publisher_.epoch_.load());
+  return publisher_.current_.load();
+}
+
+void SnapshotPublisher::Reader::Release() {
+  publisher_.slots_[slot_].epoch.store(kIdle);
+}
+
+void* SnapshotPublisher::Slot::operator new[](size_t size) {
+  // Without a destructor to run, new[] puts no element count in front of
+  // the slots, so the first one starts where it is aligned here.
+  static_assert(std::is_trivially_destructible<Slot>::value,
+      "slots must not need an array cookie");
+  void* slots = nullptr;
+  if (posix_memalign(&slots, alignof(Slot), size) != 0) {
+    throw std::bad_alloc();
+  }
+  return slots;
+}
+
+void SnapshotPublisher::Slot::operator delete[](void* slots) noexcept {
+  free(slots);
+}
+
+SnapshotPublisher::SnapshotPublisher(size_t max_readers)
+    : slots_(new Slot[max_readers]), slot_count_(max_readers) {
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+  for (size_t i = 0; i < slot_count_; ++i) {
+    assert(!slots_[i].in_use.load());
+  }
+  delete current_.load();
+  for (const auto& retired : retired_) {
+    delete retired.second;
+  }
+}
+
+void SnapshotPublisher::Publish(
+    std::unique_ptr<const LexiconSnapshot> snapshot) {
+  std::lock_guard<std::mutex> lock{writer_mutex_};
+  auto replaced = current_.exchange(snapshot.release());
+  if (replaced != nullptr) {
+    // Readers that announced this epoch or an earlier one may have it.
+    retired_.emplace_back(epoch_.load(), replaced);
+  }
+  epoch_.fetch_add(1);
+  ReclaimLocked();
+}
+
+void SnapshotPublisher::Reclaim() {
+  std::lock_guard<std::mutex> lock{writer_mutex_};
+  ReclaimLocked();
+}
+
+size_t SnapshotPublisher::retired() const {
+  std::lock_guard<std::mutex> lock{writer_mutex_};
+  return retired_.size();
+}
+
+void SnapshotPublisher::ReclaimLocked() {
+  auto oldest_reader = kIdle;
+  for (size_t i = 0; i < slot_count_; ++i) {
+    oldest_reader = std::min(oldest_reader, slots_[i].epoch.load());
+  }
+  auto still_used = std::partition(retired_.begin(), retired_.end(),
+      [oldest_reader](const std::pair<uint64_t, const LexiconSnapshot*>& r) {
+        return r.first >= oldest_reader;
+      });
+  for (auto iter = still_used; iter != retired_.end(); ++iter) {
+    delete iter->second;
+  }
+  retired_.erase(still_used, retired_.end());
+}
+
+}  // namespace morfessor
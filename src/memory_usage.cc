@@ -0,0 +1,86 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "memory_usage.h"
+
+#include <sys/resource.h>
+
+#include <iomanip>
+#include <ostream>
+
+namespace morfessor {
+
+size_t MemoryUsage::total() const {
+  size_t bytes = 0;
+  for (const auto& part : parts) {
+    bytes += part.second;
+  }
+  return bytes;
+}
+
+size_t heap_bytes(const std::string& str) {
+  // An empty string's capacity is how much fits inline.
+  static const auto inline_capacity = std::string().capacity();
+  return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+size_t peak_rss_bytes() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // Linux reports kilobytes.
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+std::ostream& print_table(std::ostream& out,
+    const std::vector<std::pair<std::string, MemoryUsage> >& usages) {
+  auto old_flags = out.flags();
+  for (const auto& usage : usages) {
+    for (const auto& part : usage.second.parts) {
+      out << std::left << std::setw(36) << usage.first + "." + part.first
+          << std::right << std::setw(18) << part.second << "\n";
+    }
+    out << std::left << std::setw(36) << usage.first + ".total"
+        << std::right << std::setw(18) << usage.second.total() << "\n";
+  }
+  out << std::left << std::setw(36) << "peak_rss"
+      << std::right << std::setw(18) << peak_rss_bytes() << "\n";
+  out.flags(old_flags);
+  return out;
+}
+
+std::ostream& print_json(std::ostream& out,
+    const std::vector<std::pair<std::string, MemoryUsage> >& usages) {
+  out << "{";
+  for (const auto& usage : usages) {
+    out << "\"" << usage.first << "\":{";
+    for (const auto& part : usage.second.parts) {
+      out << "\"" << part.first << "\":" << part.second << ",";
+    }
+    out << "\"total\":" << usage.second.total() << "},";
+  }
+  out << "\"peak_rss\":" << peak_rss_bytes() << "}";
+  return out;
+}
+
+}  // namespace morfessor
@@ -22,35 +22,225 @@
 
 #include "model.h"
 
+#include <array>
 #include <cmath>
+#include <cstdlib>
+#include <future>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 #include "morph.h"
+#include "thread_pool.h"
 
 namespace morfessor {
 
-BaselineModel::BaselineModel(const Corpus& corpus)
-    : Model(corpus, AlgorithmModes::kBaseline, 0.5, 7.0, 1.0) {}
+namespace {
+
+// Costs are saved as hex floats so that they can be read back exactly.
+// Streams cannot parse hex floats, so they are read as strings.
+Cost ReadCost(std::istream& in) {
+  std::string token;
+  in >> token;
+  return std::strtod(token.c_str(), nullptr);
+}
+
+void ExpectLabel(std::istream& in, const std::string& label) {
+  std::string token;
+  if (!(in >> token) || token != label) {
+    throw std::runtime_error("Expected \"" + label + "\" in saved model");
+  }
+}
+
+// Number of words summed up by one task when a model goes over a corpus.
+// The sums of the chunks are added together in order, so a model comes out
+// the same however many threads it was built with, but not necessarily the
+// same as with another chunk size.
+constexpr size_t kChunkWords = 1 << 16;
+
+// Maps every chunk of the corpus to a result and folds the results in
+// chunk order. The chunks are mapped on a thread pool unless there is only
+// one thread to map them on.
+template <class Map, class Fold>
+void ReduceChunks(const Corpus& corpus, size_t threads, const Map& map,
+    const Fold& fold) {
+  auto chunks = (corpus.size() + kChunkWords - 1) / kChunkWords;
+  auto chunk_begin = [&corpus](size_t chunk) {
+    return corpus.cbegin() + chunk * kChunkWords;
+  };
+  auto chunk_end = [&corpus](size_t chunk) {
+    return (chunk + 1) * kChunkWords < corpus.size()
+        ? corpus.cbegin() + (chunk + 1) * kChunkWords : corpus.cend();
+  };
+  if (threads == 1 || chunks < 2) {
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+      fold(map(chunk_begin(chunk), chunk_end(chunk)));
+    }
+    return;
+  }
+
+  ThreadPool pool{threads};
+  std::vector<std::future<decltype(map(corpus.cbegin(), corpus.cend()))> >
+      results;
+  results.reserve(chunks);
+  for (size_t chunk = 0; chunk < chunks; ++chunk) {
+    auto begin = chunk_begin(chunk);
+    auto end = chunk_end(chunk);
+    results.push_back(pool.Submit([&map, begin, end]() {
+      return map(begin, end);
+    }));
+  }
+  for (auto& result : results) {
+    fold(result.get());
+  }
+}
+
+// The letters of one chunk of a corpus.
+struct ChunkLetters {
+  std::array<size_t, 256> counts{};
+  std::array<bool, 256> seen{};
+
+  // The letters in the order they first appear, so that they are added to
+  // the hash table in the same order as when counting one word at a time.
+  std::string order;
+
+  size_t total_letters = 0;
+  size_t total_words = 0;
+};
+
+}  // namespace
+
+AlgorithmModes ParseAlgorithmMode(const std::string& name) {
+  for (auto mode : {AlgorithmModes::kBaseline, AlgorithmModes::kBaselineFreq,
+      AlgorithmModes::kBaselineLength, AlgorithmModes::kBaselineFreqLength}) {
+    if (name == AlgorithmModeName(mode)) {
+      return mode;
+    }
+  }
+  throw std::invalid_argument("Unknown algorithm mode \"" + name + "\"");
+}
+
+const char* AlgorithmModeName(AlgorithmModes mode) {
+  switch (mode) {
+    case AlgorithmModes::kBaselineFreq: return "Freq";
+    case AlgorithmModes::kBaselineLength: return "Length";
+    case AlgorithmModes::kBaselineFreqLength: return "FreqLength";
+    default: return "Baseline";
+  }
+}
+
+BaselineModel::BaselineModel(const Corpus& corpus, size_t threads)
+    : Model(corpus, AlgorithmModes::kBaseline, 0.5, 7.0, 1.0, threads) {}
 
 BaselineLengthModel::BaselineLengthModel(const Corpus& corpus,
-    double most_common_morph_length, double beta)
+    double most_common_morph_length, double beta, size_t threads)
     : Model(corpus, AlgorithmModes::kBaselineLength,
-        0.5, most_common_morph_length, beta) {}
+        0.5, most_common_morph_length, beta, threads) {}
 
 BaselineFrequencyModel::BaselineFrequencyModel(const Corpus& corpus,
-    double hapax_legomena_prior)
+    double hapax_legomena_prior, size_t threads)
     : Model(corpus, AlgorithmModes::kBaselineFreq, hapax_legomena_prior,
-        7.0, 1.0) {}
+        7.0, 1.0, threads) {}
 
 BaselineFrequencyLengthModel::BaselineFrequencyLengthModel(
     const Corpus& corpus, double hapax_legomena_prior,
-    double most_common_morph_length, double beta)
+    double most_common_morph_length, double beta, size_t threads)
     : Model(corpus, AlgorithmModes::kBaselineFreqLength, hapax_legomena_prior,
-        most_common_morph_length, beta) {}
+        most_common_morph_length, beta, threads) {}
+
+LetterStatistics::LetterStatistics(const Corpus& corpus, size_t threads) {
+  Add(corpus, threads);
+}
+
+void LetterStatistics::Add(const Corpus& corpus, size_t threads) {
+  ReduceChunks(corpus, threads,
+      [](Corpus::const_iterator begin, Corpus::const_iterator end) {
+        ChunkLetters letters;
+        for (auto iter = begin; iter != end; ++iter) {
+          letters.total_words += iter->frequency();
+          letters.total_letters += iter->frequency() * iter->length();
+          for (auto c : iter->letters()) {
+            auto index = static_cast<unsigned char>(c);
+            if (!letters.seen[index]) {
+              letters.seen[index] = true;
+              letters.order += c;
+            }
+            letters.counts[index] += iter->frequency();
+          }
+        }
+        return letters;
+      },
+      [this](const ChunkLetters& letters) {
+        total_words += letters.total_words;
+        total_letters += letters.total_letters;
+        for (auto c : letters.order) {
+          counts[c] += letters.counts[static_cast<unsigned char>(c)];
+        }
+      });
+}
+
+void Model::CorpusCosts::Add(const CorpusCosts& later) {
+  types += later.types;
+  tokens += later.tokens;
+  frequencies += later.frequencies;
+  lengths += later.lengths;
+  strings += later.strings;
+  // Compensated like add_to_corpus_log_token_sum, taking the error the
+  // later sum carries along.
+  auto compensated_term = later.log_token_sum
+      - later.log_token_sum_error - log_token_sum_error;
+  auto new_sum = log_token_sum + compensated_term;
+  log_token_sum_error = (new_sum - log_token_sum) - compensated_term;
+  log_token_sum = new_sum;
+}
+
+Model::CorpusCosts Model::CountCorpusCosts(Corpus::const_iterator begin,
+    Corpus::const_iterator end) const {
+  // The same terms as adjust_frequency_cost, adjust_length_cost,
+  // adjust_string_cost and adjust_corpus_cost, added in the same order.
+  CorpusCosts costs;
+  for (auto iter = begin; iter != end; ++iter) {
+    int frequency = iter->frequency();
+    ++costs.types;
+    costs.tokens += iter->frequency();
+    if (explicit_frequency()) {
+      costs.frequencies += frequency >= 0
+          ? explicit_frequency_cost(frequency)
+          : -explicit_frequency_cost(-frequency);
+    }
+    Cost string_cost = 0;
+    for (auto c : iter->letters()) {
+      string_cost += letter_probabilities_.at(c);
+    }
+    costs.strings += string_cost;
+    costs.lengths += explicit_length()
+        ? explicit_length_cost(iter->length())
+        : letter_probabilities_.at(' ');
+
+    auto term = frequency * std::log(std::abs(frequency));
+    auto compensated_term = term - costs.log_token_sum_error;
+    auto new_sum = costs.log_token_sum + compensated_term;
+    costs.log_token_sum_error =
+        (new_sum - costs.log_token_sum) - compensated_term;
+    costs.log_token_sum = new_sum;
+  }
+  return costs;
+}
 
 Model::Model(const Corpus& corpus, AlgorithmModes mode, double hapax,
-    double most_common_morph_length, double beta)
-    : algorithm_mode_{mode},
-      gamma_{most_common_morph_length / beta + 1, beta} {
+    double most_common_morph_length, double beta, size_t threads)
+    : Model(corpus, LetterStatistics{corpus, threads}, mode, hapax,
+        most_common_morph_length, beta, threads) {}
+
+Model::Model(const Corpus& corpus, LetterStatistics letters,
+    AlgorithmModes mode, double hapax, double most_common_morph_length,
+    double beta, size_t threads)
+    : gamma_{most_common_morph_length / beta + 1, beta},
+      algorithm_mode_{mode},
+      letters_{std::move(letters)} {
   // Set gamma parameters
   assert(beta > 0);
   assert(most_common_morph_length > 0);
@@ -62,58 +252,189 @@ Model::Model(const Corpus& corpus, AlgorithmModes mode, double hapax,
 
   // We have to know this before we can accurately calculate some of the
   // adjustments later on.
-  UpdateLetterProbabilities(corpus);
-
-  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
-    ++unique_morph_types_;
-    total_morph_tokens_ += iter->frequency();
-    adjust_frequency_cost(iter->frequency());
-    adjust_string_cost(iter->letters(), true);
-    adjust_length_cost(iter->letters().length());
-    adjust_corpus_cost(iter->frequency());
-  }
+  UpdateLetterProbabilities();
+
+  // The first chunk is taken as it is, so that a corpus of one chunk gets
+  // exactly the costs of adding its words one at a time.
+  CorpusCosts costs;
+  bool first = true;
+  ReduceChunks(corpus, threads,
+      [this](Corpus::const_iterator begin, Corpus::const_iterator end) {
+        return CountCorpusCosts(begin, end);
+      },
+      [&costs, &first](const CorpusCosts& chunk) {
+        if (first) {
+          costs = chunk;
+          first = false;
+        } else {
+          costs.Add(chunk);
+        }
+      });
+  unique_morph_types_ = costs.types;
+  total_morph_tokens_ = costs.tokens;
+  cost_from_frequencies_ = costs.frequencies;
+  cost_from_lengths_ = costs.lengths;
+  cost_from_strings_ = costs.strings;
+  cost_from_corpus_log_token_sum_ = costs.log_token_sum;
+  corpus_log_token_sum_error_ = costs.log_token_sum_error;
 }
 
 Model::~Model() {}
 
-void Model::UpdateLetterProbabilities(const Corpus& corpus)
+void Model::adjust_leaf_counts(const std::vector<MorphCountChange>& changes) {
+  adjust_leaf_counts(changes.data(), changes.size());
+}
+
+void Model::adjust_leaf_counts(const MorphCountChange* changes,
+    size_t count) {
+  long long delta_tokens = 0;
+  long long delta_types = 0;
+  Cost delta_log_token_sum = 0;
+  Cost delta_frequencies = 0;
+  Cost delta_lengths = 0;
+  Cost delta_strings = 0;
+
+  for (auto change = changes; change != changes + count; ++change) {
+    delta_tokens += static_cast<long long>(change->new_count)
+        - static_cast<long long>(change->old_count);
+
+    // Subtract the old contribution of the morph and add the contribution
+    // of the new count.
+    if (change->old_count > 0) {
+      delta_log_token_sum -= change->old_count * std::log(change->old_count);
+      if (explicit_frequency()) {
+        delta_frequencies -= explicit_frequency_cost(change->old_count);
+      }
+    }
+    if (change->new_count > 0) {
+      delta_log_token_sum += change->new_count * std::log(change->new_count);
+      if (explicit_frequency()) {
+        delta_frequencies += explicit_frequency_cost(change->new_count);
+      }
+    }
+
+    // Adding or removing a morph changes the lexicon as well.
+    int sign = 0;
+    if (change->old_count == 0 && change->new_count > 0) {
+      sign = 1;
+    } else if (change->new_count == 0 && change->old_count > 0) {
+      sign = -1;
+    }
+    if (sign != 0) {
+      delta_types += sign;
+      delta_lengths += sign * (explicit_length()
+          ? explicit_length_cost(change->morph.length())
+          : letter_probabilities_.at(' '));
+      for (auto c : change->morph) {
+        delta_strings += sign * letter_probabilities_.at(c);
+      }
+    }
+  }
+
+  assert(delta_tokens >= 0 || static_cast<size_t>(-delta_tokens) <=
+         total_morph_tokens_);
+  assert(delta_types >= 0 || static_cast<size_t>(-delta_types) <=
+         unique_morph_types_);
+  total_morph_tokens_ += delta_tokens;
+  unique_morph_types_ += delta_types;
+  add_to_corpus_log_token_sum(delta_log_token_sum);
+  cost_from_frequencies_ += delta_frequencies;
+  cost_from_lengths_ += delta_lengths;
+  cost_from_strings_ += delta_strings;
+}
+
+void Model::SaveState(std::ostream& out) const {
+  out << "model " << static_cast<unsigned int>(algorithm_mode_) << "\n"
+      << "tokens " << total_morph_tokens_ << " " << unique_morph_types_
+      << "\n" << std::hexfloat
+      << "costs " << cost_from_frequencies_ << " " << cost_from_lengths_
+      << " " << cost_from_strings_ << " " << cost_from_corpus_
+      << " " << cost_from_lexicon_order_
+      << " " << cost_from_corpus_log_token_sum_
+      << " " << corpus_log_token_sum_error_ << "\n"
+      << std::defaultfloat
+      << "letters " << letters_.total_letters << " " << letters_.total_words
+      << " " << letters_.counts.size() << "\n";
+  // Letters are written as numbers since the end of morph marker is a space.
+  for (const auto& iter : letters_.counts) {
+    out << static_cast<int>(iter.first) << " " << iter.second << "\n";
+  }
+}
+
+void Model::LoadState(std::istream& in) {
+  unsigned int mode;
+  ExpectLabel(in, "model");
+  if (!(in >> mode) || mode != static_cast<unsigned int>(algorithm_mode_)) {
+    throw std::runtime_error("Saved model uses a different algorithm mode");
+  }
+
+  ExpectLabel(in, "tokens");
+  in >> total_morph_tokens_ >> unique_morph_types_;
+
+  ExpectLabel(in, "costs");
+  cost_from_frequencies_ = ReadCost(in);
+  cost_from_lengths_ = ReadCost(in);
+  cost_from_strings_ = ReadCost(in);
+  cost_from_corpus_ = ReadCost(in);
+  cost_from_lexicon_order_ = ReadCost(in);
+  cost_from_corpus_log_token_sum_ = ReadCost(in);
+  corpus_log_token_sum_error_ = ReadCost(in);
+
+  size_t letter_count;
+  ExpectLabel(in, "letters");
+  in >> letters_.total_letters >> letters_.total_words >> letter_count;
+  letters_.counts.clear();
+  for (size_t i = 0; i < letter_count; ++i) {
+    int letter;
+    size_t count;
+    in >> letter >> count;
+    letters_.counts[static_cast<char>(letter)] = count;
+  }
+  if (!in) {
+    throw std::runtime_error("Could not read saved model");
+  }
+
+  // The letter costs are a pure function of the counts.
+  UpdateLetterProbabilities();
+}
+
+MemoryUsage Model::memory_usage() const {
+  return MemoryUsage{{
+    {"letter_probabilities", hash_table_bytes(letter_probabilities_)},
+    {"letter_counts", hash_table_bytes(letters_.counts)}
+  }};
+}
+
+void Model::AddLetterCounts(const Corpus& new_words) {
+  letters_.Add(new_words);
+  UpdateLetterProbabilities();
+}
+
+void Model::UpdateLetterProbabilities()
 {
   // Calculate the probabilities of each letter in the corpus
   letter_probabilities_.clear();
-  size_t total_letters = 0;
-  size_t unique_morphs = 0;
-  size_t total_morph_tokens = 0;
-
-  // Get the frequency of all the letters first
-  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
-    ++unique_morphs;
-    total_morph_tokens += iter->frequency();
-    for (auto c : iter->letters())
-    {
-      total_letters += iter->frequency();
-      // letter_probabiltieis actually contains count at this point
-      letter_probabilities_[c] += iter->frequency();
-    }
-  }
+  letter_probabilities_.reserve(letters_.counts.size());
+  size_t total_letters = letters_.total_letters;
 
   if (!explicit_length()) {
     // We count the "end of morph" character as a letter
-    total_letters += total_morph_tokens;
+    total_letters += letters_.total_words;
   }
 
   // Calculate the actual letter costs using maximum likelihood
   auto log_total_letters = std::log2(total_letters);
-  for (auto iter : letter_probabilities_)
+  for (const auto& iter : letters_.counts)
   {
-    letter_probabilities_.at(iter.first) =
-        log_total_letters - std::log2(letter_probabilities_.at(iter.first));
+    letter_probabilities_[iter.first] =
+        log_total_letters - std::log2(iter.second);
   }
 
   if (!explicit_length()) {
     // The "end of morph string" character can be understood to appear
-    // at the end of every string, i.e. total_morph_tokens number of times.
+    // at the end of every string, i.e. total_words number of times.
     letter_probabilities_[' '] =
-        log_total_letters - std::log2(total_morph_tokens);
+        log_total_letters - std::log2(letters_.total_words);
   }
 }
 
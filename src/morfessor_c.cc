@@ -0,0 +1,172 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morfessor.h"
+
+#include <fstream>
+#include <memory>
+#include <new>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+
+struct morfessor_model {
+  std::unique_ptr<morfessor::Segmentation> segmentation;
+};
+
+namespace {
+
+std::shared_ptr<morfessor::Model> MakeModel(const morfessor::Corpus& corpus,
+    const morfessor_options& options) {
+  switch (options.model_type) {
+    case MORFESSOR_BASELINE:
+      return std::make_shared<morfessor::BaselineModel>(corpus);
+    case MORFESSOR_BASELINE_FREQUENCY:
+      return std::make_shared<morfessor::BaselineFrequencyModel>(corpus,
+          options.hapax);
+    case MORFESSOR_BASELINE_LENGTH:
+      return std::make_shared<morfessor::BaselineLengthModel>(corpus,
+          options.most_common_length, options.beta);
+    case MORFESSOR_BASELINE_FREQUENCY_LENGTH:
+      return std::make_shared<morfessor::BaselineFrequencyLengthModel>(
+          corpus, options.hapax, options.most_common_length, options.beta);
+  }
+  return nullptr;
+}
+
+// The same limits as the morfessor program's flags.
+bool ValidOptions(const morfessor_options& options) {
+  return options.model_type >= MORFESSOR_BASELINE &&
+      options.model_type <= MORFESSOR_BASELINE_FREQUENCY_LENGTH &&
+      options.hapax > 0 && options.hapax < 1 && options.beta > 0 &&
+      options.most_common_length > 0 &&
+      options.most_common_length < 24 * options.beta;
+}
+
+}  // namespace
+
+extern "C" {
+
+void morfessor_default_options(morfessor_options* options) {
+  options->model_type = MORFESSOR_BASELINE;
+  options->hapax = 0.5;
+  options->most_common_length = 7;
+  options->beta = 1.0;
+}
+
+morfessor_status morfessor_load(const char* path,
+    const morfessor_options* options, morfessor_model** model) {
+  if (path == nullptr || model == nullptr) {
+    return MORFESSOR_ERROR_INVALID_ARGUMENT;
+  }
+  morfessor_options defaults;
+  morfessor_default_options(&defaults);
+  if (options == nullptr) {
+    options = &defaults;
+  }
+  if (!ValidOptions(*options)) {
+    return MORFESSOR_ERROR_INVALID_ARGUMENT;
+  }
+
+  try {
+    std::ifstream file{path};
+    if (!file.is_open()) {
+      return MORFESSOR_ERROR_IO;
+    }
+    morfessor::Corpus corpus{file};
+    if (file.bad()) {
+      return MORFESSOR_ERROR_IO;
+    }
+    std::unique_ptr<morfessor_model> loaded{new morfessor_model};
+    loaded->segmentation.reset(
+        new morfessor::Segmentation(corpus, MakeModel(corpus, *options)));
+    *model = loaded.release();
+    return MORFESSOR_OK;
+  } catch (const std::bad_alloc&) {
+    return MORFESSOR_ERROR_OUT_OF_MEMORY;
+  } catch (...) {
+    return MORFESSOR_ERROR_INTERNAL;
+  }
+}
+
+void morfessor_free(morfessor_model* model) {
+  delete model;
+}
+
+morfessor_status morfessor_segment(const morfessor_model* model,
+    const char* const* words, const size_t* lengths, size_t count,
+    size_t* boundaries, size_t capacity, size_t* offsets) {
+  if (model == nullptr || offsets == nullptr ||
+      (count > 0 && (words == nullptr || lengths == nullptr))) {
+    return MORFESSOR_ERROR_INVALID_ARGUMENT;
+  }
+  size_t total_length = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (words[i] == nullptr && lengths[i] > 0) {
+      return MORFESSOR_ERROR_INVALID_ARGUMENT;
+    }
+    total_length += lengths[i];
+  }
+  if (total_length > capacity) {
+    return MORFESSOR_ERROR_BUFFER_TOO_SMALL;
+  }
+  if (total_length > 0 && boundaries == nullptr) {
+    return MORFESSOR_ERROR_INVALID_ARGUMENT;
+  }
+
+  try {
+    // Each calling thread keeps its own working memory, so after the first
+    // few words nothing more is allocated.
+    thread_local morfessor::Segmentation::DecodeBuffers buffers;
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i) {
+      offsets[i + 1] = offsets[i] + model->segmentation->SegmentWord(
+          words[i], lengths[i], buffers, boundaries + offsets[i]);
+    }
+    return MORFESSOR_OK;
+  } catch (const std::bad_alloc&) {
+    return MORFESSOR_ERROR_OUT_OF_MEMORY;
+  } catch (...) {
+    return MORFESSOR_ERROR_INTERNAL;
+  }
+}
+
+const char* morfessor_status_string(morfessor_status status) {
+  switch (status) {
+    case MORFESSOR_OK:
+      return "success";
+    case MORFESSOR_ERROR_IO:
+      return "the model file could not be read";
+    case MORFESSOR_ERROR_INVALID_ARGUMENT:
+      return "invalid argument";
+    case MORFESSOR_ERROR_BUFFER_TOO_SMALL:
+      return "the boundaries buffer is too small";
+    case MORFESSOR_ERROR_OUT_OF_MEMORY:
+      return "out of memory";
+    case MORFESSOR_ERROR_INTERNAL:
+      return "internal error";
+  }
+  return "unknown status";
+}
+
+}  // extern "C"
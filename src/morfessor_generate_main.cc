@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "synthetic_corpus.h"
+
+using SyntheticCorpusGenerator = morfessor::SyntheticCorpusGenerator;
+using SyntheticCorpusOptions = morfessor::SyntheticCorpusOptions;
+
+DEFINE_string(output, "", "where to write the \"frequency word\" list, or "
+    "stdout if empty");
+DEFINE_string(gold, "", "where to write the segmentation of each word, in "
+    "the Morpho Challenge gold standard format");
+DEFINE_string(inventory, "", "file with one morph per line, most common "
+    "first, instead of a generated inventory");
+DEFINE_uint64(words, 10000, "number of distinct words to write");
+DEFINE_uint64(morphs, 1000, "number of morphs in a generated inventory");
+DEFINE_string(alphabet, "abcdefghijklmnopqrstuvwxyz", "letters of the "
+    "generated morphs");
+DEFINE_uint64(min_morph_length, 2, "shortest generated morph");
+DEFINE_uint64(max_morph_length, 6, "longest generated morph");
+DEFINE_uint64(min_morphs, 1, "fewest morphs in a word");
+DEFINE_uint64(max_morphs, 4, "most morphs in a word");
+DEFINE_double(morph_exponent, 1.0, "Zipf exponent of the morph choice");
+DEFINE_double(word_exponent, 1.0, "Zipf exponent of the word frequencies");
+DEFINE_uint64(max_count, 100000, "frequency of the most common word");
+DEFINE_uint64(seed, 1, "random seed; the same seed gives the same output");
+
+static bool ValidatePositive(const char* flagname, uint64_t value) {
+  return value > 0;
+}
+
+static bool ValidateExponent(const char* flagname, double value) {
+  return value >= 0;
+}
+
+int main(int argc, char** argv)
+{
+  gflags::RegisterFlagValidator(&FLAGS_words, &ValidatePositive);
+  gflags::RegisterFlagValidator(&FLAGS_morphs, &ValidatePositive);
+  gflags::RegisterFlagValidator(&FLAGS_min_morph_length, &ValidatePositive);
+  gflags::RegisterFlagValidator(&FLAGS_min_morphs, &ValidatePositive);
+  gflags::RegisterFlagValidator(&FLAGS_max_count, &ValidatePositive);
+  gflags::RegisterFlagValidator(&FLAGS_morph_exponent, &ValidateExponent);
+  gflags::RegisterFlagValidator(&FLAGS_word_exponent, &ValidateExponent);
+
+  gflags::SetUsageMessage("writes a Zipfian synthetic word list with a "
+      "known segmentation");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  SyntheticCorpusOptions options;
+  options.word_types = FLAGS_words;
+  options.morph_types = FLAGS_morphs;
+  options.alphabet = FLAGS_alphabet;
+  options.min_morph_length = FLAGS_min_morph_length;
+  options.max_morph_length = FLAGS_max_morph_length;
+  options.min_morphs = FLAGS_min_morphs;
+  options.max_morphs = FLAGS_max_morphs;
+  options.morph_exponent = FLAGS_morph_exponent;
+  options.word_exponent = FLAGS_word_exponent;
+  options.max_count = FLAGS_max_count;
+  options.seed = FLAGS_seed;
+
+  try {
+    std::vector<std::string> morphs;
+    if (!FLAGS_inventory.empty()) {
+      std::ifstream inventory{FLAGS_inventory};
+      if (!inventory.is_open()) {
+        std::cerr << "cannot open " << FLAGS_inventory << std::endl;
+        return 1;
+      }
+      std::string morph;
+      while (inventory >> morph) {
+        morphs.push_back(morph);
+      }
+    }
+    auto generator = FLAGS_inventory.empty()
+        ? SyntheticCorpusGenerator(options)
+        : SyntheticCorpusGenerator(options, std::move(morphs));
+
+    std::ofstream output_file;
+    std::ostream* output = &std::cout;
+    if (!FLAGS_output.empty()) {
+      output_file.open(FLAGS_output);
+      output = &output_file;
+    }
+    std::ofstream gold;
+    if (!FLAGS_gold.empty()) {
+      gold.open(FLAGS_gold);
+    }
+    generator.Generate(*output, FLAGS_gold.empty() ? nullptr : &gold);
+    if (!*output || (!FLAGS_gold.empty() && !gold)) {
+      std::cerr << "could not write the output" << std::endl;
+      return 1;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
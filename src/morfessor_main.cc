@@ -20,23 +20,44 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
+#include <csignal>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 
 #include "corpus.h"
+#include "epoch_stats.h"
+#include "evaluation.h"
+#include "instrumentation.h"
+#include "memory_usage.h"
 #include "model.h"
+#include "output_buffer.h"
+#include "restarts.h"
 #include "segmentation.h"
+#include "server.h"
+#include "sweep.h"
+#include "text_segmenter.h"
 
 using Corpus = morfessor::Corpus;
 using Segmentation = morfessor::Segmentation;
 using AlgorithmModes = morfessor::AlgorithmModes;
 using Model = morfessor::Model;
+using Phase = morfessor::instrumentation::Phase;
+using PhaseTimer = morfessor::instrumentation::PhaseTimer;
 
 DEFINE_string(mode, "Baseline", "algorithm version to use "
     "(Baseline, Freq, Length, FreqLength)");
@@ -46,6 +67,92 @@ DEFINE_double(hapax, 0.5, "prior probability for "
     "proportion of morphs that only appear once. Must be in range (0,1)");
 DEFINE_double(finish, 0.005, "threshold for when to stop trying to improve"
     " the lexicon cost. Must be in range (0,1)");
+DEFINE_bool(update, false, "with --load, add the --data words to the loaded "
+    "model and retrain incrementally instead of segmenting them. The morphs "
+    "of the model stand in for the words it was trained on, so this only "
+    "approximates retraining. To retrain on all the words, pass them as "
+    "--data without --load, and start from the saved splits with "
+    "--warm_start_tree");
+DEFINE_string(progress, "", "write a JSON line with training progress after "
+    "every pass to this file, or to stderr if set to -");
+DEFINE_string(checkpoint, "", "while training, save a checkpoint to this file "
+    "so that an interrupted run can be continued with --resume");
+DEFINE_int32(checkpoint_interval, 1, "number of passes over the lexicon "
+    "between checkpoints");
+DEFINE_bool(resume, false, "continue training from the --checkpoint file, "
+    "if it exists");
+DEFINE_string(warm_start, "", "start training from the segmentation of the "
+    "--data words under this previously trained model, instead of from "
+    "every word unsplit");
+DEFINE_string(warm_start_tree, "", "start training from the split trees "
+    "saved by a previous run with --save_tree, instead of from every word "
+    "unsplit");
+DEFINE_string(save_tree, "", "after training, save the split trees to this "
+    "file, for use with --warm_start_tree");
+DEFINE_string(dot, "", "after training, draw the split trees in this "
+    "graphviz dot file");
+DEFINE_string(dot_words, "", "with --dot, comma separated words to draw "
+    "the trees of, or empty for every word");
+DEFINE_int32(dot_min_count, 0, "with --dot, leave out the morphs that "
+    "occur fewer times than this");
+DEFINE_int32(dot_max_depth, 0, "with --dot, draw at most this many levels "
+    "of each tree, counting the word as the first, or 0 for no limit");
+DEFINE_bool(serve, false, "with --load, keep the model in memory and "
+    "segment words sent one per line on stdin, or on --socket, answering "
+    "one line per word");
+DEFINE_string(socket, "", "with --serve, listen for clients on this Unix "
+    "domain socket instead of using stdin and stdout");
+DEFINE_string(text, "", "with --load, segment the tokens of this running "
+    "text, or of stdin if it is -, and write the text to stdout with the "
+    "whitespace unchanged");
+DEFINE_string(separator, " + ", "with --text, written between the morphs "
+    "of a token");
+DEFINE_string(morph_ids, "", "with --load, write the segmentation of the "
+    "--data words as morph IDs to this path plus .ids, with an index of "
+    "where each word starts in .offsets and the morph of each ID in .vocab, "
+    "instead of printing the segmentations");
+DEFINE_string(morph_id_encoding, "varint", "with --morph_ids, how to pack "
+    "the IDs: varint or fixed32");
+DEFINE_string(gold, "", "with --load, score the segmentation of the --data "
+    "words against this gold standard and print precision, recall and "
+    "F-measure instead of the segmentations");
+DEFINE_int32(nbest, 1, "with --load, print this many of the cheapest "
+    "segmentations of each --data word, one per line after its rank and "
+    "cost. With 1, the default, the best segmentations are printed as "
+    "usual, without rank and cost");
+DEFINE_bool(sweep, false, "train one model of the --data words for every "
+    "combination of the --sweep_* values, several at a time, and print a "
+    "table of their costs");
+DEFINE_string(sweep_modes, "", "with --sweep, comma separated algorithm "
+    "versions, or empty for --mode");
+DEFINE_string(sweep_hapax, "", "with --sweep, comma separated values of "
+    "--hapax, or empty for --hapax");
+DEFINE_string(sweep_most_common_length, "", "with --sweep, comma separated "
+    "values of --most_common_length, or empty for --most_common_length");
+DEFINE_string(sweep_beta, "", "with --sweep, comma separated values of "
+    "--beta, or empty for --beta");
+DEFINE_string(test_data, "", "with --sweep and --gold, word list to segment "
+    "with each trained model and score against the gold standard");
+DEFINE_int32(restarts, 1, "train this many times with different seeds, "
+    "several at a time, abandoning runs that fall clearly behind, and keep "
+    "the segmentation with the lowest cost");
+DEFINE_uint64(seed, 0, "seed for shuffling the words while training, so "
+    "that the result is reproducible; with --restarts, the seed of the "
+    "first run; 0 for a random seed");
+DEFINE_int32(threads, 0, "number of worker threads for counting the "
+    "letters and costs of the training words, and with --serve, --text, "
+    "--gold, --sweep or --restarts, or 0 for one per hardware thread");
+DEFINE_int32(batch_size, 256, "with --serve, maximum number of words "
+    "segmented by one worker task");
+DEFINE_bool(sort_output, false, "write the lexicon and the split trees "
+    "sorted by morph, so that the same model always gives the same file");
+DEFINE_int32(output_threads, 1, "number of threads to format the lexicon "
+    "and the split trees with");
+DEFINE_string(stats, "", "count the work done on the hot paths and time "
+    "each phase, and print a summary to stderr at exit (table, json)");
+DEFINE_string(memory_report, "", "print the bytes used by each data "
+    "structure to stderr at exit, and the number of nodes and peak memory "
+    "after every pass (table, json)");
 DEFINE_double(most_common_length, 7, "most common morph length");
 DEFINE_double(beta, 1.0, "beta value for morph length Gamma "
     "distribution");
@@ -59,12 +166,39 @@ static bool ValidateLoad(const char* flagname, const std::string& path) {
 }
 
 static bool ValidateData(const char* flagname, const std::string& path) {
-  return access(path.c_str(), F_OK) != -1;
+  // Only the server and running text can do without a word list.
+  return (path == "" && (FLAGS_serve || !FLAGS_text.empty())) ||
+      access(path.c_str(), F_OK) != -1;
+}
+
+static bool ValidateEncoding(const char* flagname,
+    const std::string& encoding) {
+  return encoding == "varint" || encoding == "fixed32";
 }
 
 static bool ValidateMode(const char* flagname, const std::string& mode) {
-  return mode == "Baseline" || mode == "Freq" || mode == "Length" ||
-      mode == "FreqLength";
+  try {
+    morfessor::ParseAlgorithmMode(mode);
+    return true;
+  } catch (const std::invalid_argument&) {
+    return false;
+  }
+}
+
+static bool ValidateFormat(const char* flagname, const std::string& format) {
+  return format == "" || format == "table" || format == "json";
+}
+
+static bool ValidateInterval(const char* flagname, int32_t interval) {
+  return interval > 0;
+}
+
+static bool ValidateThreads(const char* flagname, int32_t threads) {
+  return threads >= 0;
+}
+
+static bool ValidateNonNegative(const char* flagname, int32_t value) {
+  return value >= 0;
 }
 
 static bool ValidateBeta(const char* flagname, double beta) {
@@ -75,55 +209,469 @@ static bool ValidateLength(const char* flagname, double length) {
   return length > 0 && length < 24*FLAGS_beta;
 }
 
+// Set algorithm parameters
+static std::shared_ptr<Model> MakeModel(const Corpus& corpus) {
+  switch (morfessor::ParseAlgorithmMode(FLAGS_mode)) {
+    case AlgorithmModes::kBaselineFreq:
+      return std::make_shared<morfessor::BaselineFrequencyModel>(corpus,
+          FLAGS_hapax, FLAGS_threads);
+    case AlgorithmModes::kBaselineLength:
+      return std::make_shared<morfessor::BaselineLengthModel>(corpus,
+          FLAGS_most_common_length, FLAGS_beta, FLAGS_threads);
+    case AlgorithmModes::kBaselineFreqLength:
+      return std::make_shared<morfessor::BaselineFrequencyLengthModel>(
+          corpus, FLAGS_hapax, FLAGS_most_common_length, FLAGS_beta,
+          FLAGS_threads);
+    default:
+      return std::make_shared<morfessor::BaselineModel>(corpus,
+          FLAGS_threads);
+  }
+}
+
+// Prints the hot path counters and phase times.
+static void ReportStats() {
+  if (FLAGS_stats == "json") {
+    morfessor::instrumentation::print_json(std::cerr) << std::endl;
+  } else if (FLAGS_stats == "table") {
+    morfessor::instrumentation::print_table(std::cerr);
+  }
+}
+
+// Returns how to write the lexicon and the split trees.
+static morfessor::OutputOptions MakeOutputOptions() {
+  morfessor::OutputOptions options;
+  options.sorted = FLAGS_sort_output;
+  options.threads = FLAGS_output_threads;
+  return options;
+}
+
+// Splits a comma separated flag value.
+static std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream in{list};
+  std::string item;
+  while (getline(in, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+// Writes the results of training: the dot graph and the split trees if
+// asked for, and the lexicon on stdout.
+static void WriteTrainingOutput(const Segmentation& st) {
+  if (!FLAGS_dot.empty()) {
+    morfessor::DotFilter filter;
+    filter.words = SplitList(FLAGS_dot_words);
+    filter.min_count = FLAGS_dot_min_count;
+    filter.max_depth = FLAGS_dot_max_depth;
+    auto out = std::ofstream(FLAGS_dot);
+    st.print_dot(out, filter, MakeOutputOptions());
+  }
+  if (!FLAGS_save_tree.empty()) {
+    auto tree = std::ofstream(FLAGS_save_tree);
+    st.print_tree(tree, MakeOutputOptions());
+  }
+  st.print(std::cout, MakeOutputOptions());
+}
+
+// Reads a comma separated list of numbers, or the default if it is empty.
+static std::vector<double> ParseValues(const std::string& list,
+    double default_value) {
+  std::vector<double> values;
+  for (const auto& item : SplitList(list)) {
+    values.push_back(std::stod(item));
+  }
+  if (values.empty()) {
+    values.push_back(default_value);
+  }
+  return values;
+}
+
+// Trains a model for every combination of the --sweep_* values and prints
+// how each one did. Returns the exit status.
+static int RunSweep(const Corpus& corpus) {
+  std::vector<AlgorithmModes> modes;
+  for (const auto& mode : SplitList(FLAGS_sweep_modes.empty()
+      ? FLAGS_mode : FLAGS_sweep_modes)) {
+    if (!ValidateMode("sweep_modes", mode)) {
+      std::cerr << "unknown mode in --sweep_modes: " << mode << std::endl;
+      return 1;
+    }
+    modes.push_back(morfessor::ParseAlgorithmMode(mode));
+  }
+  std::vector<morfessor::SweepConfiguration> grid;
+  try {
+    grid = morfessor::MakeSweepGrid(modes,
+        ParseValues(FLAGS_sweep_hapax, FLAGS_hapax),
+        ParseValues(FLAGS_sweep_most_common_length,
+            FLAGS_most_common_length),
+        ParseValues(FLAGS_sweep_beta, FLAGS_beta));
+  } catch (const std::logic_error&) {
+    std::cerr << "--sweep_* values must be comma separated numbers"
+        << std::endl;
+    return 1;
+  }
+  // The same limits as for the single value flags.
+  for (const auto& configuration : grid) {
+    if (!ValidateProportion("hapax", configuration.hapax) ||
+        !ValidateBeta("beta", configuration.beta) ||
+        configuration.most_common_length <= 0 ||
+        configuration.most_common_length >= 24*configuration.beta) {
+      std::cerr << "invalid --sweep_* value" << std::endl;
+      return 1;
+    }
+  }
+
+  std::unique_ptr<Corpus> test_corpus;
+  std::unique_ptr<morfessor::GoldStandard> gold;
+  if (!FLAGS_gold.empty() && !FLAGS_test_data.empty()) {
+    test_corpus.reset(new Corpus{FLAGS_test_data});
+    gold.reset(new morfessor::GoldStandard{FLAGS_gold});
+  }
+  auto results = morfessor::Sweep(corpus, grid, FLAGS_threads,
+      test_corpus.get(), gold.get());
+  morfessor::print_table(std::cout, results);
+  return 0;
+}
+
+// Prints the number of nodes and the peak memory after a pass.
+static void ReportEpochMemory(size_t epoch, const Segmentation& st) {
+  if (FLAGS_memory_report == "json") {
+    std::cerr << "{\"epoch\":" << epoch << ",\"nodes\":" << st.size()
+        << ",\"peak_rss\":" << morfessor::peak_rss_bytes() << "}"
+        << std::endl;
+  } else {
+    std::cerr << "epoch " << epoch << ": " << st.size() << " nodes, "
+        << morfessor::peak_rss_bytes() << " bytes peak RSS" << std::endl;
+  }
+}
+
+// Prints the bytes used by each data structure.
+static void ReportMemory(const Corpus& corpus, const Segmentation& st,
+    const Model& model) {
+  std::vector<std::pair<std::string, morfessor::MemoryUsage> > usages{
+    {"corpus", corpus.memory_usage()},
+    {"segmentation", st.memory_usage()},
+    {"model", model.memory_usage()}
+  };
+  if (FLAGS_memory_report == "json") {
+    morfessor::print_json(std::cerr, usages) << std::endl;
+  } else {
+    morfessor::print_table(std::cerr, usages);
+  }
+}
+
+// Prints the --nbest segmentations of every test word: its rank, starting
+// from 1 for each word, the cost and the morphs each followed by a space.
+static void PrintKBest(const Segmentation& st, const Corpus& test_corpus) {
+  Segmentation::KBestDecodeBuffers buffers;
+  std::vector<morfessor::ScoredSegmentation> paths;
+  std::string line;
+  morfessor::OutputBuffer out{std::cout};
+  for (auto iter = test_corpus.cbegin(); iter != test_corpus.cend(); ++iter) {
+    const auto& word = iter->letters();
+    auto count = st.SegmentWord(word.data(), word.length(), FLAGS_nbest,
+        buffers, paths);
+    for (size_t rank = 0; rank < count; ++rank) {
+      line.clear();
+      morfessor::AppendSegmentation(word, paths[rank].boundaries.data(),
+          paths[rank].boundaries.size(), line);
+      out.AppendUnsigned(rank + 1) << '\t';
+      out.AppendFixed(paths[rank].cost, 6) << '\t' << line << '\n';
+    }
+  }
+  out.Flush();
+}
+
+// Writes the segmentation of every test word as morph IDs, and the
+// vocabulary, to the --morph_ids files. Returns the exit status.
+static int WriteMorphIds(const Segmentation& st, const Corpus& test_corpus) {
+  auto vocabulary = st.Vocabulary();
+  auto vocab_path = FLAGS_morph_ids + ".vocab";
+  auto ids_path = FLAGS_morph_ids + ".ids";
+  auto offsets_path = FLAGS_morph_ids + ".offsets";
+  {
+    std::ofstream vocab{vocab_path};
+    if (!vocab.is_open()) {
+      std::cerr << "cannot open " << vocab_path << std::endl;
+      return 1;
+    }
+    vocabulary->print(vocab);
+    if (!vocab.flush()) {
+      std::cerr << "cannot write " << vocab_path << std::endl;
+      return 1;
+    }
+  }
+  std::ofstream ids{ids_path, std::ios::binary};
+  if (!ids.is_open()) {
+    std::cerr << "cannot open " << ids_path << std::endl;
+    return 1;
+  }
+  std::ofstream offsets{offsets_path, std::ios::binary};
+  if (!offsets.is_open()) {
+    std::cerr << "cannot open " << offsets_path << std::endl;
+    return 1;
+  }
+  morfessor::MorphIdWriter writer{ids, offsets,
+      FLAGS_morph_id_encoding == "fixed32"
+          ? morfessor::MorphIdEncoding::kFixed32
+          : morfessor::MorphIdEncoding::kVarint};
+
+  size_t longest_word = 0;
+  for (auto iter = test_corpus.cbegin(); iter != test_corpus.cend(); ++iter) {
+    longest_word = std::max(longest_word, iter->length());
+  }
+  Segmentation::DecodeBuffers buffers;
+  std::vector<size_t> boundaries(longest_word);
+  std::vector<uint32_t> morph_ids(longest_word);
+  for (auto iter = test_corpus.cbegin(); iter != test_corpus.cend(); ++iter) {
+    const auto& word = iter->letters();
+    auto morph_count = vocabulary->SegmentWord(word.data(), word.length(),
+        buffers, boundaries.data(), morph_ids.data());
+    writer.Add(morph_ids.data(), morph_count);
+  }
+  writer.Finish();
+  if (!ids.flush()) {
+    std::cerr << "cannot write " << ids_path << std::endl;
+    return 1;
+  }
+  if (!offsets.flush()) {
+    std::cerr << "cannot write " << offsets_path << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Trains --restarts segmentations and prints the best one, with a summary
+// of every run on stderr.
+static void RunRestarts(const Corpus& corpus, uint32_t seed) {
+  PhaseTimer phase{Phase::kOptimize};
+  auto mode = morfessor::ParseAlgorithmMode(FLAGS_mode);
+  auto result = morfessor::OptimizeWithRestarts(corpus,
+      [&corpus, mode](const morfessor::LetterStatistics& letters) {
+        return std::make_shared<Model>(corpus, letters, mode, FLAGS_hapax,
+            FLAGS_most_common_length, FLAGS_beta);
+      }, FLAGS_restarts, seed, FLAGS_threads);
+  for (size_t i = 0; i < result.outcomes.size(); ++i) {
+    const auto& outcome = result.outcomes[i];
+    std::cerr << "seed " << outcome.seed << ": "
+        << (outcome.abandoned ? "abandoned" : "converged") << " after "
+        << outcome.epochs << " passes, cost " << std::fixed
+        << outcome.overall_cost << std::defaultfloat
+        << (i == result.best ? " (kept)" : "") << std::endl;
+  }
+
+  phase.Switch(Phase::kOutput);
+  WriteTrainingOutput(*result.segmentation);
+  if (!FLAGS_memory_report.empty()) {
+    ReportMemory(corpus, *result.segmentation, *result.model);
+  }
+}
+
 int main(int argc, char** argv)
 {
   gflags::RegisterFlagValidator(&FLAGS_hapax, &ValidateProportion);
   gflags::RegisterFlagValidator(&FLAGS_finish, &ValidateProportion);
   gflags::RegisterFlagValidator(&FLAGS_data, &ValidateData);
   gflags::RegisterFlagValidator(&FLAGS_load, &ValidateLoad);
+  gflags::RegisterFlagValidator(&FLAGS_warm_start, &ValidateLoad);
+  gflags::RegisterFlagValidator(&FLAGS_warm_start_tree, &ValidateLoad);
+  gflags::RegisterFlagValidator(&FLAGS_gold, &ValidateLoad);
+  gflags::RegisterFlagValidator(&FLAGS_test_data, &ValidateLoad);
   gflags::RegisterFlagValidator(&FLAGS_mode, &ValidateMode);
   gflags::RegisterFlagValidator(&FLAGS_most_common_length, &ValidateLength);
   gflags::RegisterFlagValidator(&FLAGS_beta, &ValidateBeta);
+  gflags::RegisterFlagValidator(&FLAGS_checkpoint_interval,
+      &ValidateInterval);
+  gflags::RegisterFlagValidator(&FLAGS_batch_size, &ValidateInterval);
+  gflags::RegisterFlagValidator(&FLAGS_restarts, &ValidateInterval);
+  gflags::RegisterFlagValidator(&FLAGS_nbest, &ValidateInterval);
+  gflags::RegisterFlagValidator(&FLAGS_output_threads, &ValidateInterval);
+  gflags::RegisterFlagValidator(&FLAGS_dot_min_count, &ValidateNonNegative);
+  gflags::RegisterFlagValidator(&FLAGS_dot_max_depth, &ValidateNonNegative);
+  gflags::RegisterFlagValidator(&FLAGS_morph_id_encoding, &ValidateEncoding);
+  gflags::RegisterFlagValidator(&FLAGS_threads, &ValidateThreads);
+  gflags::RegisterFlagValidator(&FLAGS_stats, &ValidateFormat);
+  gflags::RegisterFlagValidator(&FLAGS_memory_report, &ValidateFormat);
 
   google::ParseCommandLineFlags(&argc, &argv, true);
 
+  morfessor::instrumentation::Enable(!FLAGS_stats.empty());
+
   std::shared_ptr<Corpus> corpus = nullptr;
+  {
+    PhaseTimer phase{Phase::kLoad};
+    if (FLAGS_load.empty()) {
+      corpus = std::make_shared<Corpus>(FLAGS_data);
+    } else {
+      corpus = std::make_shared<Corpus>(FLAGS_load);
+    }
+  }
+
+  if (FLAGS_sweep) {
+    int status;
+    {
+      PhaseTimer phase{Phase::kOptimize};
+      status = RunSweep(*corpus);
+    }
+    ReportStats();
+    return status;
+  }
+
+  // Runs shuffle with seed, seed + 1, ... so the seed fits in 32 bits.
+  auto seed = FLAGS_seed != 0 ? static_cast<uint32_t>(FLAGS_seed)
+      : std::random_device{}();
+
+  if (FLAGS_load.empty() && FLAGS_restarts > 1) {
+    if (!FLAGS_checkpoint.empty() || !FLAGS_warm_start.empty() ||
+        !FLAGS_warm_start_tree.empty()) {
+      std::cerr << "--restarts does not work with checkpoints or warm starts"
+          << std::endl;
+      return 1;
+    }
+    RunRestarts(*corpus, seed);
+    ReportStats();
+    return 0;
+  }
+
   std::shared_ptr<Model> model = nullptr;
+  {
+    PhaseTimer phase{Phase::kModelInit};
+    model = MakeModel(*corpus);
+  }
 
-  if (FLAGS_load.empty()) {
-    corpus = std::make_shared<Corpus>(FLAGS_data);
-  } else {
-    corpus = std::make_shared<Corpus>(FLAGS_load);
-  }
-
-  // Set algorithm parameters
-  if (FLAGS_mode == "FreqLength") {
-    model = std::make_shared<morfessor::BaselineModel>(*corpus);
-  } else if (FLAGS_mode == "Freq") {
-    model = std::make_shared<morfessor::BaselineFrequencyModel>(*corpus,
-        FLAGS_hapax);
-  } else if (FLAGS_mode == "Length") {
-    model = std::make_shared<morfessor::BaselineLengthModel>(*corpus,
-        FLAGS_most_common_length, FLAGS_beta);
-  } else {
-    model = std::make_shared<morfessor::BaselineFrequencyLengthModel>(*corpus,
-        FLAGS_hapax, FLAGS_most_common_length, FLAGS_beta);
+  // Training progress goes to stderr or a file, one JSON object per line.
+  std::ofstream progress_file;
+  std::ostream* progress = nullptr;
+  if (FLAGS_progress == "-") {
+    progress = &std::cerr;
+  } else if (!FLAGS_progress.empty()) {
+    progress_file.open(FLAGS_progress);
+    if (!progress_file.is_open()) {
+      std::cerr << "cannot open " << FLAGS_progress << std::endl;
+      return 1;
+    }
+    progress = &progress_file;
   }
+  auto report_epochs = progress || !FLAGS_memory_report.empty();
+  auto epoch_callback = [progress](const Segmentation& st) {
+    return [progress, &st](const morfessor::EpochStats& stats) {
+      if (progress) {
+        morfessor::print_json(*progress, stats) << std::endl;
+      }
+      if (!FLAGS_memory_report.empty()) {
+        ReportEpochMemory(stats.epoch, st);
+      }
+    };
+  };
 
   if (FLAGS_load.empty()) {
+    PhaseTimer phase{Phase::kModelInit};
     Segmentation st(*corpus, model);
+    st.set_seed(seed);
+    if (report_epochs) {
+      st.set_epoch_callback(epoch_callback(st));
+    }
+    auto resuming = false;
+    if (!FLAGS_checkpoint.empty()) {
+      st.set_checkpoint(FLAGS_checkpoint, FLAGS_checkpoint_interval);
+      // Without a checkpoint to resume from, we just start from scratch.
+      std::ifstream checkpoint{FLAGS_checkpoint};
+      if (FLAGS_resume && checkpoint.is_open()) {
+        st.LoadCheckpoint(checkpoint);
+        resuming = true;
+      }
+    }
+    if (!resuming && !FLAGS_warm_start_tree.empty()) {
+      std::ifstream tree{FLAGS_warm_start_tree};
+      st.WarmStart(tree);
+    } else if (!resuming && !FLAGS_warm_start.empty()) {
+      Corpus previous_lexicon{FLAGS_warm_start};
+      Segmentation previous(previous_lexicon, MakeModel(previous_lexicon));
+      st.WarmStart(previous);
+    }
+    phase.Switch(Phase::kOptimize);
     st.Optimize();
-    auto out = std::ofstream("output.dot");
-    st.print_dot(out);
-    std::cout << st;
+    phase.Switch(Phase::kOutput);
+    WriteTrainingOutput(st);
+    if (!FLAGS_memory_report.empty()) {
+      ReportMemory(*corpus, st, *model);
+    }
+  } else if (FLAGS_serve) {
+    // A client that stops reading ends its session, not the server: writes
+    // to its closed pipe fail with EPIPE instead of raising SIGPIPE.
+    std::signal(SIGPIPE, SIG_IGN);
+    Segmentation st(*corpus, model);
+    morfessor::SegmentationServer server(st, FLAGS_threads, FLAGS_batch_size);
+    if (FLAGS_socket.empty()) {
+      server.Serve(STDIN_FILENO, STDOUT_FILENO);
+    } else {
+      server.ListenUnix(FLAGS_socket);
+    }
+  } else if (!FLAGS_text.empty()) {
+    PhaseTimer phase{Phase::kModelInit};
+    Segmentation st(*corpus, model);
+    phase.Switch(Phase::kOutput);
+    auto in = STDIN_FILENO;
+    if (FLAGS_text != "-") {
+      in = open(FLAGS_text.c_str(), O_RDONLY);
+      if (in < 0) {
+        std::cerr << "cannot open " << FLAGS_text << std::endl;
+        return 1;
+      }
+    }
+    morfessor::TextSegmenter segmenter(st, FLAGS_separator, FLAGS_threads);
+    segmenter.Segment(in, STDOUT_FILENO);
+    if (in != STDIN_FILENO) {
+      close(in);
+    }
+  } else if (FLAGS_update) {
+    // The loaded model only lists morphs, so they are what Update adds the
+    // new words to, in place of the words the model was trained on.
+    PhaseTimer phase{Phase::kModelInit};
+    Segmentation st(*corpus, model);
+    if (report_epochs) {
+      st.set_epoch_callback(epoch_callback(st));
+    }
+    phase.Switch(Phase::kLoad);
+    Corpus new_words{FLAGS_data};
+    phase.Switch(Phase::kOptimize);
+    st.Update(new_words);
+    phase.Switch(Phase::kOutput);
+    st.print(std::cout, MakeOutputOptions());
+    if (!FLAGS_memory_report.empty()) {
+      ReportMemory(*corpus, st, *model);
+    }
   } else {
+    PhaseTimer phase{Phase::kModelInit};
     Segmentation st(*corpus, model);
+    phase.Switch(Phase::kLoad);
     Corpus test_corpus{FLAGS_data};
-    auto segments = st.SegmentTestCorpus(test_corpus);
-    for (auto word_splits : *segments) {
-      std::cout << word_splits << std::endl;
+    // Segmenting the words counts as output, since nothing is trained.
+    phase.Switch(Phase::kOutput);
+    if (!FLAGS_gold.empty()) {
+      morfessor::GoldStandard gold{FLAGS_gold};
+      morfessor::print_table(std::cout, morfessor::Evaluate(st, test_corpus,
+          gold, FLAGS_threads));
+    } else if (!FLAGS_morph_ids.empty()) {
+      if (WriteMorphIds(st, test_corpus) != 0) {
+        return 1;
+      }
+    } else if (FLAGS_nbest > 1) {
+      // Only ranked lists get ranks and costs, so that --nbest 1 keeps the
+      // usual output.
+      PrintKBest(st, test_corpus);
+    } else {
+      morfessor::OutputBuffer out{std::cout};
+      st.SegmentTestCorpusLines(test_corpus,
+          [&out](const std::string& line) { out << line << '\n'; });
+      out.Flush();
+    }
+    if (!FLAGS_memory_report.empty()) {
+      ReportMemory(*corpus, st, *model);
     }
   }
 
+  ReportStats();
   return 0;
 }
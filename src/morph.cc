@@ -22,11 +22,13 @@
 
 #include "morph.h"
 
+#include <utility>
+
 namespace morfessor
 {
 
 Morph::Morph(std::string letters, size_t frequency)
-: letters_{letters},
+: letters_{std::move(letters)},
   frequency_{frequency}
 {
 }
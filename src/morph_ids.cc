@@ -0,0 +1,181 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morph_ids.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <ostream>
+#include <stdexcept>
+
+namespace morfessor {
+
+constexpr size_t MorphIdWriter::kFlushSize;
+
+MorphVocabulary::MorphVocabulary(
+    std::vector<std::pair<std::string, size_t> > morph_counts,
+    Cost log_token_count)
+    : log_token_count_(log_token_count) {
+  std::sort(morph_counts.begin(), morph_counts.end(),
+      [](const std::pair<std::string, size_t>& left,
+          const std::pair<std::string, size_t>& right) {
+        return left.second != right.second ? left.second > right.second
+            : left.first < right.first;
+      });
+  morphs_.reserve(morph_counts.size() + 1);
+  morphs_.emplace_back(std::string(), 0);
+  entries_.reserve(morph_counts.size());
+  for (auto& morph_count : morph_counts) {
+    auto id = static_cast<uint32_t>(morphs_.size());
+    entries_.emplace(morph_count.first, Entry{id,
+        log_token_count_ - std::log(morph_count.second)});
+    max_morph_length_ = std::max(max_morph_length_,
+        morph_count.first.length());
+    morphs_.push_back(std::move(morph_count));
+  }
+}
+
+const std::string& MorphVocabulary::morph(uint32_t id) const {
+  assert(id < morphs_.size());
+  return morphs_[id].first;
+}
+
+size_t MorphVocabulary::count(uint32_t id) const {
+  assert(id < morphs_.size());
+  return morphs_[id].second;
+}
+
+size_t MorphVocabulary::SegmentWord(const char* word, size_t length,
+    DecodeBuffers& buffers, size_t* boundaries, uint32_t* ids) const {
+  return ViterbiIds(word, length, log_token_count_, max_morph_length_,
+      [this](const std::string& morph, Cost& cost, uint32_t& id) {
+        auto found = entries_.find(morph);
+        if (found == entries_.end()) {
+          return false;
+        }
+        cost = found->second.cost;
+        id = found->second.id;
+        return true;
+      }, buffers, boundaries, ids);
+}
+
+std::ostream& MorphVocabulary::print(std::ostream& out) const {
+  for (size_t id = 0; id < morphs_.size(); ++id) {
+    out << id << '\t' << morphs_[id].first << '\t' << morphs_[id].second
+        << '\n';
+  }
+  return out;
+}
+
+MorphIdWriter::MorphIdWriter(std::ostream& ids, std::ostream& offsets,
+    MorphIdEncoding encoding)
+    : ids_out_(ids), offsets_out_(offsets), encoding_(encoding) {
+  ids_.reserve(kFlushSize + 5 * 64);
+  offsets_.reserve(kFlushSize + 8);
+}
+
+MorphIdWriter::~MorphIdWriter() {
+  if (!finished_) {
+    Finish();
+  }
+}
+
+template <class T>
+void MorphIdWriter::AppendFixed(std::string& buffer, T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    buffer += static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+void MorphIdWriter::Add(const uint32_t* ids, size_t count) {
+  assert(!finished_);
+  AppendFixed<uint64_t>(offsets_, position_ + ids_.size());
+  ++words_;
+  for (size_t i = 0; i < count; ++i) {
+    auto id = ids[i];
+    if (encoding_ == MorphIdEncoding::kFixed32) {
+      AppendFixed<uint32_t>(ids_, id);
+    } else {
+      while (id >= 0x80) {
+        ids_ += static_cast<char>((id & 0x7f) | 0x80);
+        id >>= 7;
+      }
+      ids_ += static_cast<char>(id);
+    }
+  }
+  if (ids_.size() >= kFlushSize || offsets_.size() >= kFlushSize) {
+    Flush();
+  }
+}
+
+void MorphIdWriter::Finish() {
+  assert(!finished_);
+  AppendFixed<uint64_t>(offsets_, position_ + ids_.size());
+  Flush();
+  ids_out_.flush();
+  offsets_out_.flush();
+  finished_ = true;
+}
+
+void MorphIdWriter::Flush() {
+  ids_out_.write(ids_.data(), ids_.size());
+  offsets_out_.write(offsets_.data(), offsets_.size());
+  position_ += ids_.size();
+  ids_.clear();
+  offsets_.clear();
+}
+
+void UnpackMorphIds(const char* data, size_t length,
+    MorphIdEncoding encoding, std::vector<uint32_t>& ids) {
+  ids.clear();
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  if (encoding == MorphIdEncoding::kFixed32) {
+    if (length % 4 != 0) {
+      throw std::runtime_error("morph IDs are not a multiple of 4 bytes");
+    }
+    for (size_t i = 0; i < length; i += 4) {
+      ids.push_back(bytes[i] | bytes[i + 1] << 8 | bytes[i + 2] << 16 |
+          static_cast<uint32_t>(bytes[i + 3]) << 24);
+    }
+    return;
+  }
+  uint32_t id = 0;
+  unsigned shift = 0;
+  for (size_t i = 0; i < length; ++i) {
+    if (shift > 28) {
+      throw std::runtime_error("morph ID is longer than 32 bits");
+    }
+    id |= static_cast<uint32_t>(bytes[i] & 0x7f) << shift;
+    shift += 7;
+    if (!(bytes[i] & 0x80)) {
+      ids.push_back(id);
+      id = 0;
+      shift = 0;
+    }
+  }
+  if (shift != 0) {
+    throw std::runtime_error("morph IDs end in the middle of an ID");
+  }
+}
+
+}  // namespace morfessor
@@ -0,0 +1,55 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morph_key.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <ostream>
+
+namespace morfessor {
+
+MorphKey MorphKey::Copy(const char* letters, size_t length) {
+  auto copy = new char[length];
+  std::copy(letters, letters + length, copy);
+  return MorphKey(copy, length, true);
+}
+
+MorphKey MorphKey::substr(size_t pos, size_t length) const {
+  assert(pos + length <= length_);
+  return owns_letters_ ? Copy(data_ + pos, length)
+      : View(data_ + pos, length);
+}
+
+bool operator<(const MorphKey& left, const MorphKey& right) noexcept {
+  auto common = std::min(left.length(), right.length());
+  auto order = common == 0 ? 0
+      : std::memcmp(left.data(), right.data(), common);
+  return order != 0 ? order < 0 : left.length() < right.length();
+}
+
+std::ostream& operator<<(std::ostream& out, const MorphKey& key) {
+  return out.write(key.data(), key.length());
+}
+
+} // namespace morfessor
@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "output_buffer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+namespace morfessor {
+
+namespace {
+
+// The two digits of every number below 100.
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+}  // namespace
+
+char* FormatDecimal(uint64_t value, char* end) {
+  // Two digits at a time, from the back.
+  while (value >= 100) {
+    auto pair = kDigitPairs + 2 * (value % 100);
+    value /= 100;
+    *--end = pair[1];
+    *--end = pair[0];
+  }
+  if (value >= 10) {
+    auto pair = kDigitPairs + 2 * value;
+    *--end = pair[1];
+    *--end = pair[0];
+  } else {
+    *--end = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+OutputBuffer::OutputBuffer(std::ostream& out, size_t capacity)
+    : out_(out), capacity_(capacity) {
+  buffer_.reserve(capacity);
+}
+
+OutputBuffer::~OutputBuffer() {
+  Drain();
+}
+
+OutputBuffer& OutputBuffer::Append(const char* data, size_t length) {
+  if (buffer_.size() + length > capacity_) {
+    Drain();
+    if (length > capacity_) {
+      // Not worth copying.
+      out_.write(data, length);
+      return *this;
+    }
+  }
+  buffer_.append(data, length);
+  return *this;
+}
+
+OutputBuffer& OutputBuffer::Append(char c) {
+  if (buffer_.size() == capacity_) {
+    Drain();
+  }
+  buffer_ += c;
+  return *this;
+}
+
+OutputBuffer& OutputBuffer::AppendUnsigned(uint64_t value) {
+  char digits[20];
+  auto end = digits + sizeof(digits);
+  auto begin = FormatDecimal(value, end);
+  return Append(begin, end - begin);
+}
+
+OutputBuffer& OutputBuffer::AppendFixed(double value, int precision) {
+  // Rare enough that snprintf is fine.
+  char text[64];
+  auto length = std::snprintf(text, sizeof(text), "%.*f", precision, value);
+  if (length < 0 || length >= static_cast<int>(sizeof(text))) {
+    std::string long_text(length > 0 ? length + 1 : 512, '\0');
+    length = std::snprintf(&long_text[0], long_text.size(), "%.*f",
+        precision, value);
+    return Append(long_text.data(), length);
+  }
+  return Append(text, length);
+}
+
+void OutputBuffer::Flush() {
+  Drain();
+  out_.flush();
+}
+
+void OutputBuffer::Drain() {
+  if (!buffer_.empty()) {
+    out_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+}
+
+}  // namespace morfessor
@@ -0,0 +1,116 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "restarts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "epoch_stats.h"
+#include "thread_pool.h"
+
+namespace morfessor {
+
+namespace {
+
+/// What the runs of OptimizeWithRestarts share.
+struct Race {
+  std::mutex mutex;
+
+  /// The lowest cost any run had after each pass, and how much that run
+  /// gained in the pass.
+  std::vector<std::pair<Cost, Cost> > best_at_epoch;
+
+  /// The best converged run so far.
+  RestartResult result;
+  bool has_best = false;
+};
+
+}  // namespace
+
+RestartResult OptimizeWithRestarts(const Corpus& corpus,
+    const ModelFactory& make_model, size_t restarts, uint32_t seed,
+    size_t threads, double margin) {
+  const LetterStatistics letters{corpus, threads};
+  Race race;
+  ThreadPool pool{threads};
+  std::vector<std::future<RestartOutcome> > outcomes;
+  for (size_t run = 0; run < restarts; ++run) {
+    outcomes.push_back(pool.Submit([&, run]() {
+      RestartOutcome outcome;
+      outcome.seed = seed + static_cast<uint32_t>(run);
+      auto model = make_model(letters);
+      std::unique_ptr<Segmentation> segmentation{
+          new Segmentation{corpus, model}};
+      segmentation->set_seed(outcome.seed);
+      auto stoppable = segmentation.get();
+      segmentation->set_epoch_callback(
+          [&race, &outcome, stoppable, margin](const EpochStats& stats) {
+            outcome.epochs = stats.epoch;
+            std::lock_guard<std::mutex> lock{race.mutex};
+            if (race.best_at_epoch.size() < stats.epoch) {
+              race.best_at_epoch.resize(stats.epoch, std::make_pair(
+                  std::numeric_limits<Cost>::infinity(), Cost{0}));
+            }
+            auto& best = race.best_at_epoch[stats.epoch - 1];
+            if (margin >= 0 && stats.overall_cost >
+                best.first + margin * std::abs(best.second)) {
+              outcome.abandoned = true;
+              stoppable->Stop();
+            }
+            if (stats.overall_cost < best.first) {
+              best = std::make_pair(stats.overall_cost, stats.cost_delta);
+            }
+          });
+      segmentation->Optimize();
+      segmentation->set_epoch_callback(nullptr);
+      outcome.overall_cost = model->overall_cost();
+
+      if (!outcome.abandoned) {
+        std::lock_guard<std::mutex> lock{race.mutex};
+        // Ties go to the lower seed, so that one thread always gives the
+        // same answer.
+        if (!race.has_best ||
+            outcome.overall_cost < race.result.model->overall_cost() ||
+            (outcome.overall_cost == race.result.model->overall_cost() &&
+                run < race.result.best)) {
+          race.result.model = std::move(model);
+          race.result.segmentation = std::move(segmentation);
+          race.result.best = run;
+          race.has_best = true;
+        }
+      }
+      // A run that is not the best frees its segmentation here.
+      return outcome;
+    }));
+  }
+  for (auto& outcome : outcomes) {
+    race.result.outcomes.push_back(outcome.get());
+  }
+  return std::move(race.result);
+}
+
+}  // namespace morfessor
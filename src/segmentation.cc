@@ -22,28 +22,46 @@
 
 #include "segmentation.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <iomanip>
 #include <random>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 
 #include "corpus.h"
+#include "instrumentation.h"
 #include "morph.h"
 
 namespace morfessor {
 
 Segmentation::Segmentation(const Corpus& training_corpus,
     std::shared_ptr<Model> model)
-    : nodes_{}, model_{model} {
+    : nodes_{}, word_storage_{training_corpus.words()}, model_{model},
+      rng_{std::random_device{}()} {
   // The model has already initialized based on the corpus, so here we just
   // need to add the words to the data structure, without considering their
-  // cost.
-  for (auto iter = training_corpus.cbegin(); iter != training_corpus.cend();
-      ++iter) {
-    nodes_.emplace(iter->letters(), iter->frequency());
+  // cost. The keys view the words the corpus holds, so no letters are
+  // copied. The table is not reserved up front: its bucket count decides
+  // the order the words are first resplit in, and with it the result of a
+  // seeded run.
+  for (const auto& word : *word_storage_.front()) {
+    nodes_.emplace(MorphKey::View(word.letters()), word.frequency());
+  }
+}
+
+Segmentation::~Segmentation() {
+  // A failed write cannot be reported from here, so only wait for it.
+  if (checkpoint_write_.valid()) {
+    checkpoint_write_.wait();
   }
 }
 
@@ -51,147 +69,312 @@ std::shared_ptr<std::vector<std::string> >
 Segmentation::SegmentTestCorpus(const Corpus& test_corpus) {
   auto segmentations = std::make_shared<std::vector<std::string> >();
   segmentations->reserve(test_corpus.size());
+  SegmentTestCorpus(test_corpus, [&segmentations](const std::string& word,
+      const size_t* boundaries, size_t morph_count) {
+    segmentations->emplace_back();
+    auto& str = segmentations->back();
+    str.reserve(word.length() + morph_count);
+    AppendSegmentation(word, boundaries, morph_count, str);
+  });
+  return segmentations;
+}
 
-  auto log_token_count =
-      std::log(model_->total_morph_tokens());
+void Segmentation::SegmentTestCorpus(const Corpus& test_corpus,
+    const BoundarySink& sink) const {
+  // Shared by all the words and sized for the longest one up front, so
+  // that decoding allocates nothing.
+  size_t longest_word = 0;
+  for (auto iter = test_corpus.cbegin(); iter != test_corpus.cend(); ++iter) {
+    longest_word = std::max(longest_word, iter->length());
+  }
+  DecodeBuffers buffers;
+  buffers.delta.reserve(longest_word + 1);
+  buffers.psi.reserve(longest_word + 1);
+  buffers.morph.reserve(longest_word);
+  std::vector<size_t> boundaries(longest_word);
 
   for (auto iter = test_corpus.cbegin(); iter != test_corpus.cend(); ++iter) {
-    auto word = iter->letters();
-    auto word_length = iter->length();
-    auto count = iter->frequency();
-
-    double bad_likelihood = (word_length + 1) * log_token_count;
-    double pseudo_infinite_cost = (word_length + 1) * bad_likelihood;
-
-    std::vector<double> delta(word_length + 1, 0.0);
-    std::vector<double> psi(word_length + 1, 0.0);
-
-    for (auto end_index = 1; end_index <= word_length; ++end_index) {
-      double best_delta = pseudo_infinite_cost;
-      double best_length = 0;
-
-      for (auto morph_length = 1; morph_length <= end_index; ++morph_length) {
-        auto morph = word.substr(end_index - morph_length, morph_length);
-        auto morph_cost = 0;
-        if (contains(morph)) {
-          morph_cost = log_token_count - std::log(at(morph).count);
-        } else if (morph_length == 1) {
-          // The morph was undefined, and only one letter long. Accept
-          // it with a bad likelihood.
-          morph_cost = bad_likelihood;
-        } else {
-          // The morph was undefined. Keep looking elsewhere.
-          continue;
-        }
+    const auto& word = iter->letters();
+    auto morph_count = SegmentWord(word.data(), word.length(), buffers,
+        boundaries.data());
+    sink(word, boundaries.data(), morph_count);
+  }
+}
 
-        assert(end_index >= morph_length && end_index - morph_length < delta.size());
-        double current_delta = delta[end_index - morph_length] + morph_cost;
-        if (current_delta < best_delta) {
-          best_delta = current_delta;
-          best_length = morph_length;
-        }
-      }  // for each morph_length
-
-      assert(end_index > 0 && end_index < delta.size());
-      delta[end_index] = best_delta;
-      psi[end_index] = best_length;
-    }  // for each end_index
-
-    std::string str = "";
-    auto end_index = word_length;
-    while (psi[end_index] != 0) {
-      assert(end_index > 0 && end_index < psi.size());
-      str = word.substr(end_index - psi[end_index], psi[end_index]) + " " + str;
-      end_index -= psi[end_index];
-    }
-    segmentations->push_back(str);
-  }  // for each word
+void Segmentation::SegmentTestCorpusLines(const Corpus& test_corpus,
+    const LineSink& sink) const {
+  std::string line;
+  SegmentTestCorpus(test_corpus, [&line, &sink](const std::string& word,
+      const size_t* boundaries, size_t morph_count) {
+    line.clear();
+    AppendSegmentation(word, boundaries, morph_count, line);
+    sink(line);
+  });
+}
 
-  return segmentations;
+std::vector<size_t> Segmentation::SegmentWord(const std::string& word) const {
+  DecodeBuffers buffers;
+  std::vector<size_t> boundaries(word.length());
+  boundaries.resize(
+      SegmentWord(word.data(), word.length(), buffers, boundaries.data()));
+  return boundaries;
+}
+
+size_t Segmentation::SegmentWord(const char* word, size_t length,
+    DecodeBuffers& buffers, size_t* boundaries) const {
+  auto log_token_count = std::log(model_->total_morph_tokens());
+  uint64_t cells = 0;
+  auto morph_count = Viterbi(word, length, log_token_count, length,
+      [this, log_token_count, &cells](const std::string& morph, Cost& cost) {
+        ++cells;
+        return DecodeCost(morph, log_token_count, cost);
+      }, buffers, boundaries);
+  CountDecode(cells);
+  return morph_count;
+}
+
+std::vector<ScoredSegmentation> Segmentation::SegmentWord(
+    const std::string& word, size_t k) const {
+  KBestDecodeBuffers buffers;
+  std::vector<ScoredSegmentation> paths;
+  paths.resize(SegmentWord(word.data(), word.length(), k, buffers, paths));
+  return paths;
+}
+
+size_t Segmentation::SegmentWord(const char* word, size_t length, size_t k,
+    KBestDecodeBuffers& buffers,
+    std::vector<ScoredSegmentation>& paths) const {
+  auto log_token_count = std::log(model_->total_morph_tokens());
+  uint64_t cells = 0;
+  auto count = KBestViterbi(word, length, log_token_count, length, k,
+      [this, log_token_count, &cells](const std::string& morph, Cost& cost) {
+        ++cells;
+        return DecodeCost(morph, log_token_count, cost);
+      }, buffers, paths);
+  CountDecode(cells);
+  return count;
+}
+
+bool Segmentation::DecodeCost(const std::string& morph,
+    Cost log_token_count, Cost& cost) const {
+  auto node = nodes_.find(MorphKey::View(morph));
+  if (node == nodes_.end()) {
+    return false;
+  }
+  cost = log_token_count - std::log(node->second.count);
+  return true;
 }
 
-void Segmentation::AdjustMorphCount(std::string morph, int delta) {
+void Segmentation::CountDecode(uint64_t cells) {
+  if (instrumentation::enabled()) {
+    using instrumentation::Counter;
+    instrumentation::Count(Counter::kViterbiWords);
+    instrumentation::Count(Counter::kViterbiCells, cells);
+    instrumentation::Count(Counter::kNodeLookups, cells);
+  }
+}
+
+std::unique_ptr<const LexiconSnapshot> Segmentation::Snapshot() const {
+  auto log_token_count = std::log(model_->total_morph_tokens());
+  std::unordered_map<std::string, Cost> morph_costs;
+  morph_costs.reserve(nodes_.size());
+  for (const auto& node_pair : nodes_) {
+    morph_costs.emplace(node_pair.first.str(),
+        log_token_count - std::log(node_pair.second.count));
+  }
+  return std::unique_ptr<const LexiconSnapshot>(new LexiconSnapshot(
+      std::move(morph_costs), log_token_count, epoch_));
+}
+
+std::unique_ptr<const MorphVocabulary> Segmentation::Vocabulary() const {
+  std::vector<std::pair<std::string, size_t> > morph_counts;
+  morph_counts.reserve(nodes_.size());
+  for (const auto& node_pair : nodes_) {
+    morph_counts.emplace_back(node_pair.first.str(),
+        node_pair.second.count);
+  }
+  return std::unique_ptr<const MorphVocabulary>(new MorphVocabulary(
+      std::move(morph_counts), std::log(model_->total_morph_tokens())));
+}
+
+void Segmentation::AdjustMorphCount(const std::string& morph, int delta) {
   // Precondition check: Morph string cannot be empty.
   assert(!morph.empty());
 
-  // Either find the morph in the data structure, or create it.
-  // The count of a created node is 0.
-  MorphNode& subtree = nodes_[morph];
-
-  // Precondition check: Never allow node counts to become negative.
-  assert(delta >= 0 || -delta <= subtree.count);
+  // Only a morph that is not in the data structure yet needs a copy of its
+  // letters, since nothing says how long the caller's letters will last.
+  auto root = nodes_.find(MorphKey::View(morph));
+  if (root == nodes_.end()) {
+    root = nodes_.emplace(MorphKey::Copy(morph), TreeNode()).first;
+  }
+  AdjustRoot(root, delta);
+}
 
-  // We'll be changing the data structure, so we save a copy of the information
-  // here. Can't trust pointers and references into it once we start adding
-  // and removing nodes, since the map might reorganize its data in memory.
-  auto old_count = subtree.count;
-  auto new_count = subtree.count + delta;
-  auto left_child = subtree.left_child;
-  auto right_child = subtree.right_child;
+void Segmentation::AdjustMorphCount(const MorphKey& morph, int delta) {
+  // Precondition check: Morph string cannot be empty.
+  assert(!morph.empty());
 
-  // Sanity check: Splits are always binary, so if we ever see a case where
-  // a node has an odd number of children, we've done something wrong.
-  assert (left_child.empty() == right_child.empty());
+  auto root = nodes_.find(morph);
+  if (root == nodes_.end()) {
+    root = nodes_.emplace(morph, TreeNode()).first;
+  }
+  AdjustRoot(root, delta);
+}
 
-  if (new_count == 0) {
-    nodes_.erase(nodes_.find(morph));
-  } else {
-    subtree.count = new_count;
+void Segmentation::AdjustRoot(NodeMap::iterator root, int delta) {
+  // A node with a count of 0 was just added.
+  auto inserted = root->second.count == 0;
+  AdjustSubtree(*root, delta);
+  auto erased = root->second.count == 0;
+  if (erased) {
+    nodes_.erase(root);
   }
 
-  // Recursively update the node's children, if they exist. Otherwise we
-  // are dealing with a leaf node, and we have to update our costs to account
-  // for the new frequencies. Costs are only over calculated based on leaf
-  // nodes.
-  if (!left_child.empty()) {
-    AdjustMorphCount(left_child, delta);
-    AdjustMorphCount(right_child, delta);
-  } else {
-    model_->adjust_morph_token_count(delta);
+  if (instrumentation::enabled()) {
+    using instrumentation::Counter;
+    instrumentation::Count(Counter::kNodeLookups);
+    instrumentation::Count(Counter::kNodeInserts, inserted);
+    instrumentation::Count(Counter::kNodeErases, erased);
+  }
+}
 
-    // To adjust the probabilities, we subtract the old contribution of the
-    // morph and add the contribution of the new count.
-    if (old_count > 0) {
-      model_->adjust_corpus_cost(-old_count);
-      model_->adjust_frequency_cost(-old_count);
+void Segmentation::AdjustSubtree(NodeEntry& root, int delta) {
+  // Walk the subtree with an explicit stack. Node counts are updated as we
+  // go, since a morph can appear more than once in the same subtree and
+  // each visit has to see the count left behind by the previous one. The
+  // model only cares about leaf nodes, so their changes are collected and
+  // handed over in one batch once the walk is done.
+  //
+  // The stack holds the nodes themselves, reached through the links of
+  // their parents. Nothing is inserted during the walk, and a node below
+  // the root is only erased on its last visit, since its count is at least
+  // delta times the number of times it appears in the subtree, so the
+  // entries on the stack stay valid. The stack and the leaf changes never
+  // shrink, and each leaf change keeps its string, so once they have grown,
+  // walking allocates nothing.
+  pending_nodes_.clear();
+  pending_nodes_.push_back(&root);
+  size_t leaves = 0;
+
+  // Counted locally and reported once, to keep the loop cheap.
+  uint64_t visited = 0;
+  uint64_t erased = 0;
+  uint64_t max_stack = 1;
+
+  while (!pending_nodes_.empty()) {
+    auto entry = pending_nodes_.back();
+    pending_nodes_.pop_back();
+    ++visited;
+    TreeNode& subtree = entry->second;
+
+    // Precondition check: Never allow node counts to become negative.
+    assert(delta >= 0 || -delta <= subtree.count);
+
+    auto old_count = subtree.count;
+    auto new_count = subtree.count + delta;
+
+    // Sanity check: Splits are always binary, so if we ever see a case where
+    // a node has an odd number of children, we've done something wrong.
+    assert(subtree.left_child.empty() == subtree.right_child.empty());
+
+    // Queue up the children before we touch the data structure, since the
+    // node may be erased below. The right child goes on the stack first so
+    // that the left subtree is visited first.
+    auto is_leaf = !subtree.has_children();
+    if (!is_leaf) {
+      // Sanity check: The children of a node are always in the data
+      // structure, and linked.
+      assert(subtree.left_node != nullptr && subtree.right_node != nullptr);
+      pending_nodes_.push_back(subtree.right_node);
+      pending_nodes_.push_back(subtree.left_node);
+      max_stack = std::max<uint64_t>(max_stack, pending_nodes_.size());
     }
-    if (new_count > 0) {
-      model_->adjust_corpus_cost(new_count);
-      model_->adjust_frequency_cost(new_count);
+
+    // Costs are only ever calculated based on leaf nodes.
+    if (is_leaf) {
+      if (leaves == leaf_changes_.size()) {
+        leaf_changes_.emplace_back();
+      }
+      auto& change = leaf_changes_[leaves++];
+      change.morph.assign(entry->first.begin(), entry->first.end());
+      change.old_count = old_count;
+      change.new_count = new_count;
     }
 
-    if (old_count == 0 && new_count > 0) {
-      // Adding a morph
-      model_->adjust_unique_morph_count(1);
-      model_->adjust_length_cost(morph.length());
-      model_->adjust_string_cost(morph, true);
-    } else if (new_count == 0 && old_count > 0) {
-      // Removing a morph
-      model_->adjust_unique_morph_count(-1);
-      model_->adjust_length_cost(-morph.length());
-      model_->adjust_string_cost(morph, false);
+    subtree.count = new_count;
+    if (new_count == 0 && entry != &root) {
+      nodes_.erase(nodes_.find(entry->first));
+      ++erased;
     }
   }
+
+  model_->adjust_leaf_counts(leaf_changes_.data(), leaves);
+
+  if (instrumentation::enabled()) {
+    using instrumentation::Counter;
+    instrumentation::Count(Counter::kAdjustMorphCountCalls);
+    instrumentation::Count(Counter::kAdjustMorphCountNodes, visited);
+    instrumentation::CountMax(Counter::kAdjustMorphCountMaxStack, max_stack);
+    // Only erasing a node needs a lookup, for its place in the table.
+    instrumentation::Count(Counter::kNodeLookups, erased);
+    instrumentation::Count(Counter::kNodeErases, erased);
+  }
+}
+
+void Segmentation::DetachNode(NodeEntry& entry) {
+  auto& node = entry.second;
+  AdjustSubtree(entry, -static_cast<int>(node.count));
+  node.left_child.clear();
+  node.right_child.clear();
+  node.left_node = nullptr;
+  node.right_node = nullptr;
+}
+
+void Segmentation::LinkChildren(NodeMap& nodes, TreeNode& node) {
+  auto left = nodes.find(MorphKey::View(node.left_child));
+  auto right = nodes.find(MorphKey::View(node.right_child));
+  node.left_node = left != nodes.end() ? &*left : nullptr;
+  node.right_node = right != nodes.end() ? &*right : nullptr;
 }
 
-void Segmentation::ResplitNode(std::string morph) {
+void Segmentation::ResplitNode(const std::string& morph) {
+  // Resplit with the node's own key, so that the morphs split off from a
+  // word view the letters of its corpus. The node keeps its entry while it
+  // is resplit, so the key stays valid.
+  instrumentation::Count(instrumentation::Counter::kNodeLookups);
+  auto found = nodes_.find(MorphKey::View(morph));
+  if (found != nodes_.end()) {
+    ResplitNode(found->first);
+  } else {
+    ResplitNode(MorphKey::View(morph));
+  }
+}
+
+void Segmentation::ResplitNode(const MorphKey& morph) {
   // Precondition check: The morph cannot be the empty string.
   assert(!morph.empty());
 
-  // We'll be deleting the morph next, so remember its count.
-  auto frequency = nodes_.at(morph).count;
+  // Direct lookups into the data structure, counted locally like the ones
+  // in AdjustMorphCount and reported once.
+  uint64_t lookups = 0;
 
-  // Remove the current representation of the node, if we have it. This
-  // means that we recalculate the best split for a morph ever time we
-  // encounter it, which is good since the quality of a new split depends on
-  // the splits we've chosen so far. This just makes the algorithm a little
-  // less dependent on the order in which morphs are evaluated.
-  if (nodes_.find(morph) != end(nodes_)) {
-    AdjustMorphCount(morph, -frequency);
-  }
+  // We'll be taking the morph out next, so remember its count.
+  auto frequency = nodes_.at(morph).count;
+  ++lookups;
+
+  // Remove the current representation of the node. This means that we
+  // recalculate the best split for a morph ever time we encounter it, which
+  // is good since the quality of a new split depends on the splits we've
+  // chosen so far. This just makes the algorithm a little less dependent on
+  // the order in which morphs are evaluated. The node keeps its entry,
+  // unsplit and with a count of 0, since the nodes it is a child of link
+  // to it.
+  auto& entry = *nodes_.find(morph);
+  ++lookups;
+  DetachNode(entry);
 
   // Recalculate the model with the node unsplit.
-  AdjustMorphCount(morph, frequency);
+  AdjustSubtree(entry, frequency);
 
   // Save a copy of this as our current best solution.
   auto best_cost = model_->overall_cost();
@@ -202,13 +385,15 @@ void Segmentation::ResplitNode(std::string morph) {
   // pretend the morph that's being split doesn't exist anymore; as far as the
   // model is concerned, it doesn't. We'll add it back later, one way
   // or another.
-  AdjustMorphCount(morph, -frequency);
+  AdjustSubtree(entry, -frequency);
 
-  // Try every split of the node into two substrings
-  for (auto split_index = 1; split_index < morph.size(); ++split_index) {
+  // Try every split of the node into two substrings. The children of a view
+  // view the same letters, so trying them copies nothing.
+  for (size_t split_index = 1; split_index < morph.length(); ++split_index) {
     // Add the child morphs to the model.
     auto left_child = morph.substr(0, split_index);
-    auto right_child = morph.substr(split_index);
+    auto right_child = morph.substr(split_index,
+        morph.length() - split_index);
     AdjustMorphCount(left_child, frequency);
     AdjustMorphCount(right_child, frequency);
 
@@ -225,81 +410,556 @@ void Segmentation::ResplitNode(std::string morph) {
   }
 
   if (best_split_index > 0) {
+    auto left_child = morph.substr(0, best_split_index);
+    auto right_child = morph.substr(best_split_index,
+        morph.length() - best_split_index);
+
     // Readd the parent to the segmentation data structure, but not to the
-    // model, since only leaf nodes count towards the model.
-    nodes_[morph].count = frequency;
-    nodes_[morph].left_child = morph.substr(0, best_split_index);
-    nodes_[morph].right_child = morph.substr(best_split_index);
+    // model, since only leaf nodes count towards the model. The entry stays
+    // valid while its children are added, since it is never erased.
+    auto& node = entry.second;
+    node.count = frequency;
+    node.left_child.assign(left_child.begin(), left_child.end());
+    node.right_child.assign(right_child.begin(), right_child.end());
 
     // If the model says we should split, then do it and split recursively.
-    AdjustMorphCount(nodes_[morph].left_child, frequency);
-    AdjustMorphCount(nodes_[morph].right_child, frequency);
-    ResplitNode(nodes_[morph].left_child);
-    ResplitNode(nodes_[morph].right_child);
+    AdjustMorphCount(left_child, frequency);
+    AdjustMorphCount(right_child, frequency);
+    LinkChildren(nodes_, node);
+    lookups += 2;
+    ResplitNode(left_child);
+    ResplitNode(right_child);
   } else {
-    // Readd the original morph to the data structure and the model as well.
-    AdjustMorphCount(morph, frequency);
+    // Readd the original morph to the model as well.
+    AdjustSubtree(entry, frequency);
+  }
+
+  if (instrumentation::enabled()) {
+    using instrumentation::Counter;
+    instrumentation::Count(Counter::kResplitNodeCalls);
+    instrumentation::Count(Counter::kSplitCandidates, morph.length() - 1);
+    instrumentation::Count(Counter::kNodeLookups, lookups);
   }
 }
 
+void Segmentation::WarmStart(std::istream& tree) {
+  // Only the split points matter. The counts will come from our own corpus.
+  std::unordered_map<std::string, size_t> split_indices;
+  std::string line;
+  while (std::getline(tree, line)) {
+    std::istringstream fields{line};
+    size_t count;
+    std::string morph;
+    std::string left_child;
+    std::string right_child;
+    if (fields >> count >> morph >> left_child >> right_child
+        && left_child + right_child == morph) {
+      split_indices[morph] = left_child.length();
+    }
+  }
+
+  SplitWords([&split_indices](const std::string& morph) -> size_t {
+    auto iter = split_indices.find(morph);
+    return iter != split_indices.end() ? iter->second : 0;
+  });
+}
+
+void Segmentation::WarmStart(const Segmentation& previous) {
+  // A word is split where the first morph of its best segmentation under
+  // the previous model ends. The rest of the word gets split the same way
+  // when we recurse into it.
+  SplitWords([&previous](const std::string& morph) -> size_t {
+    auto boundaries = previous.SegmentWord(morph);
+    return boundaries.size() > 1 ? boundaries.front() : 0;
+  });
+}
+
+void Segmentation::SplitWords(const SplitFunction& split_index) {
+  std::vector<MorphKey> words;
+  words.reserve(nodes_.size());
+  for (const auto& node_pair : nodes_) {
+    words.push_back(node_pair.first);
+  }
+  for (const auto& word : words) {
+    SplitNode(word, split_index);
+  }
+}
+
+void Segmentation::SplitNode(const MorphKey& morph,
+    const SplitFunction& split_index) {
+  // Precondition check: The morph cannot be the empty string.
+  assert(!morph.empty());
+
+  // Like ResplitNode, except that we are told where to split instead of
+  // searching for the best split.
+  auto frequency = nodes_.at(morph).count;
+  auto& entry = *nodes_.find(morph);
+  DetachNode(entry);
+
+  auto index = split_index(morph.str());
+  if (index > 0 && index < morph.length()) {
+    auto left_child = morph.substr(0, index);
+    auto right_child = morph.substr(index, morph.length() - index);
+
+    // Readd the parent to the segmentation data structure, but not to the
+    // model, since only leaf nodes count towards the model.
+    auto& node = entry.second;
+    node.count = frequency;
+    node.left_child = left_child.str();
+    node.right_child = right_child.str();
+
+    AdjustMorphCount(left_child, frequency);
+    AdjustMorphCount(right_child, frequency);
+    LinkChildren(nodes_, node);
+    SplitNode(left_child, split_index);
+    SplitNode(right_child, split_index);
+  } else {
+    AdjustSubtree(entry, frequency);
+  }
+}
 void Segmentation::Optimize() {
-  std::vector<std::string> keys;
-  // Collect all the nodes we will iterate over
+  if (!resuming_) {
+    // Collect the words we will iterate over. After a warm start the data
+    // structure also holds the morphs split off from them, but only the
+    // words are resplit, like in a run from scratch. A word of a later
+    // corpus may already be known, so each is collected once.
+    keys_.clear();
+    std::unordered_set<MorphKey> seen;
+    for (const auto& words : word_storage_) {
+      for (const auto& word : *words) {
+        auto key = MorphKey::View(word.letters());
+        if (word.frequency() > 0 && seen.insert(key).second) {
+          keys_.push_back(key);
+        }
+      }
+    }
+    epoch_ = 0;
+  }
+
+  ResplitUntilConverged();
+}
+
+void Segmentation::Update(const Corpus& new_words) {
+  // The new letters change the cost of every morph string in the lexicon,
+  // so we take the strings out of the model under the old letter costs and
+  // put them back under the new ones.
+  std::string letters;
   for (const auto& node_pair : nodes_) {
-    keys.push_back(node_pair.first);
+    if (!node_pair.second.has_children() && node_pair.second.count > 0) {
+      letters.assign(node_pair.first.begin(), node_pair.first.end());
+      model_->adjust_string_cost(letters, false);
+    }
   }
+  model_->AddLetterCounts(new_words);
+  for (const auto& node_pair : nodes_) {
+    if (!node_pair.second.has_children() && node_pair.second.count > 0) {
+      letters.assign(node_pair.first.begin(), node_pair.first.end());
+      model_->adjust_string_cost(letters, true);
+    }
+  }
+
+  // Known words keep their current splits and just get more frequent. New
+  // words start out unsplit, like they do in the constructor, with keys
+  // that view the words of the new corpus.
+  word_storage_.push_back(new_words.words());
+  keys_.clear();
+  for (const auto& word : *word_storage_.back()) {
+    if (word.frequency() > 0) {
+      auto key = MorphKey::View(word.letters());
+      AdjustMorphCount(key, word.frequency());
+      keys_.push_back(key);
+    }
+  }
+  epoch_ = 0;
 
-  // Word list is randomly shuffled on each iteration
-  std::random_device rd;
-  std::mt19937 g(rd());
+  // Only the words that changed need a new split.
+  ResplitUntilConverged();
+}
 
+void Segmentation::ResplitUntilConverged() {
+  resuming_ = false;
   auto old_cost = model_->overall_cost();
   auto new_cost = old_cost;
-  do {
-    std::shuffle(keys.begin(), keys.end(), g);
+  auto converged = false;
+  while (!converged && !stop_requested_.load(std::memory_order_relaxed)) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Word list is randomly shuffled on each iteration
+    std::shuffle(keys_.begin(), keys_.end(), rng_);
 
     // Try splitting all the nodes
     old_cost = new_cost;
-    for (const auto& key : keys) {
+    for (const auto& key : keys_) {
+      if (stop_requested_.load(std::memory_order_relaxed)) {
+        break;
+      }
+      // Every key is a word, and a word's node is never erased, since its
+      // count is at least the word's frequency.
       ResplitNode(key);
     }
+    if (stop_requested_.load(std::memory_order_relaxed)) {
+      // The pass is incomplete, so there is nothing to report.
+      break;
+    }
     new_cost = model_->overall_cost();
-  } while (old_cost - new_cost > model_->convergence_threshold());
+    converged = old_cost - new_cost <= model_->convergence_threshold();
+    ++epoch_;
+
+    if (snapshot_publisher_) {
+      snapshot_publisher_->Publish(Snapshot());
+    }
+    if (epoch_callback_) {
+      EpochStats stats;
+      stats.epoch = epoch_;
+      stats.overall_cost = new_cost;
+      stats.lexicon_cost = model_->lexicon_cost();
+      stats.corpus_cost = model_->corpus_cost();
+      stats.cost_delta = old_cost - new_cost;
+      stats.convergence_threshold = model_->convergence_threshold();
+      stats.unique_morph_types = model_->unique_morph_types();
+      stats.total_morph_tokens = model_->total_morph_tokens();
+      stats.words_resplit = keys_.size();
+      stats.seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start_time).count();
+      epoch_callback_(stats);
+    }
+
+    if (!converged && !checkpoint_path_.empty()
+        && epoch_ % checkpoint_interval_ == 0) {
+      WriteCheckpointInBackground();
+    }
+  }
+
+  WaitForCheckpoint();
+}
+
+void Segmentation::SaveCheckpoint(std::ostream& out) const {
+  out << "morfessor-checkpoint 1\n"
+      << "epoch " << epoch_ << "\n"
+      << "rng " << rng_ << "\n";
+  model_->SaveState(out);
+
+  out << "keys " << keys_.size() << "\n";
+  for (const auto& key : keys_) {
+    out << key << "\n";
+  }
+
+  out << "nodes " << nodes_.size() << "\n";
+  print_tree(out);
+}
+
+void Segmentation::LoadCheckpoint(std::istream& in) {
+  std::string label;
+  size_t version;
+  if (!(in >> label >> version) || label != "morfessor-checkpoint"
+      || version != 1) {
+    throw std::runtime_error("Not a checkpoint file");
+  }
+
+  in >> label >> epoch_;
+  in >> label >> rng_;
+  model_->LoadState(in);
+
+  size_t key_count;
+  in >> label >> key_count;
+  std::vector<std::string> keys(key_count);
+  for (auto& key : keys) {
+    in >> key;
+  }
+
+  // Morphs that are already in the data structure, such as the words of
+  // the corpus, keep their keys. Only the others need copies of their
+  // letters.
+  size_t node_count;
+  in >> label >> node_count >> std::ws;
+  NodeMap nodes;
+  nodes.reserve(node_count);
+  std::string line;
+  for (size_t i = 0; i < node_count && std::getline(in, line); ++i) {
+    std::istringstream fields{line};
+    size_t count;
+    std::string morph;
+    fields >> count >> morph;
+    auto known = nodes_.find(MorphKey::View(morph));
+    auto& node = nodes.emplace(known != nodes_.end() ? known->first
+        : MorphKey::Copy(morph), TreeNode()).first->second;
+    node.count = count;
+    fields >> node.left_child >> node.right_child;
+  }
+
+  if (!in || nodes.size() != node_count) {
+    throw std::runtime_error("Could not read checkpoint");
+  }
+  for (auto& node_pair : nodes) {
+    auto& node = node_pair.second;
+    if (node.has_children()) {
+      LinkChildren(nodes, node);
+      if (node.left_node == nullptr || node.right_node == nullptr) {
+        throw std::runtime_error("Could not read checkpoint");
+      }
+    }
+  }
+  // The morphs being resplit are words, so they all have nodes.
+  std::vector<MorphKey> loaded_keys;
+  loaded_keys.reserve(key_count);
+  for (const auto& key : keys) {
+    auto known = nodes.find(MorphKey::View(key));
+    if (known == nodes.end()) {
+      throw std::runtime_error("Could not read checkpoint");
+    }
+    loaded_keys.push_back(known->first);
+  }
+  nodes_.swap(nodes);
+  keys_.swap(loaded_keys);
+  resuming_ = true;
 }
 
-std::ostream& Segmentation::print(std::ostream& out) const {
-  out << "Overall cost: " << std::setiosflags(std::ios::fixed)
-      << std::setprecision(5)
-      << model_->overall_cost() << std::endl;
+void Segmentation::WriteCheckpointInBackground() {
+  WaitForCheckpoint();
+
+  // Capturing the state in memory is quick. Writing it out, which can be
+  // slow for a large lexicon, happens while training carries on.
+  std::ostringstream snapshot;
+  SaveCheckpoint(snapshot);
+  checkpoint_write_ = std::async(std::launch::async,
+      [path = checkpoint_path_, contents = snapshot.str()]() {
+        // Write to a temporary file first, so an interrupted write never
+        // clobbers the last good checkpoint.
+        auto temp_path = path + ".tmp";
+        std::ofstream out{temp_path};
+        out << contents;
+        out.close();
+        if (!out || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+          throw std::runtime_error("Could not write checkpoint " + path);
+        }
+      });
+}
+
+void Segmentation::WaitForCheckpoint() {
+  if (checkpoint_write_.valid()) {
+    checkpoint_write_.get();
+  }
+}
+
+MemoryUsage Segmentation::memory_usage() const {
+  // Keys that view the words of a corpus take no memory of their own.
+  size_t key_bytes = 0;
+  size_t child_bytes = 0;
+  for (const auto& node_pair : nodes_) {
+    if (node_pair.first.owns_letters()) {
+      key_bytes += node_pair.first.length();
+    }
+    child_bytes += heap_bytes(node_pair.second.left_child) +
+        heap_bytes(node_pair.second.right_child);
+  }
+  size_t optimizer_key_bytes = keys_.capacity() * sizeof(MorphKey);
+  for (const auto& key : keys_) {
+    if (key.owns_letters()) {
+      optimizer_key_bytes += key.length();
+    }
+  }
+  using Node = decltype(nodes_)::value_type;
+  return MemoryUsage{{
+    {"node_keys", key_bytes},
+    {"nodes", nodes_.size() * hash_node_bytes<Node>()},
+    {"buckets", nodes_.bucket_count() * sizeof(void*)},
+    {"child_strings", child_bytes},
+    {"optimizer_keys", optimizer_key_bytes}
+  }};
+}
+
+std::vector<const Segmentation::NodeEntry*> Segmentation::OutputNodes(
+    bool leaves_only, bool sorted) const {
+  std::vector<const NodeEntry*> entries;
+  entries.reserve(nodes_.size());
   for (const auto& iter : nodes_) {
-    if (!iter.second.has_children()) {
-      auto& morph_string = iter.first;
-      auto& node = iter.second;
-      out << node.count << " " << morph_string << std::endl;
+    if (!leaves_only || !iter.second.has_children()) {
+      entries.push_back(&iter);
     }
   }
+  if (sorted) {
+    std::sort(entries.begin(), entries.end(),
+        [](const NodeEntry* left, const NodeEntry* right) {
+          return left->first < right->first;
+        });
+  }
+  return entries;
+}
+
+void Segmentation::PrintLeaves(OutputBuffer& out,
+    const OutputOptions& options) const {
+  auto leaves = OutputNodes(true, options.sorted);
+  WriteChunks(out, leaves.size(),
+      [&leaves](size_t begin, size_t end, std::string& text) {
+        char digits[20];
+        auto digits_end = digits + sizeof(digits);
+        for (auto i = begin; i < end; ++i) {
+          text.append(FormatDecimal(leaves[i]->second.count, digits_end),
+              digits_end);
+          text += ' ';
+          text.append(leaves[i]->first.begin(), leaves[i]->first.end());
+          text += '\n';
+        }
+      }, options.threads);
+}
+
+std::ostream& Segmentation::print(std::ostream& out,
+    const OutputOptions& options) const {
+  OutputBuffer buffer{out};
+  buffer << "Overall cost: ";
+  buffer.AppendFixed(model_->overall_cost(), 5);
+  buffer << '\n';
+  PrintLeaves(buffer, options);
+  buffer.Flush();
   return out;
 }
 
-std::ostream& Segmentation::print_dot(std::ostream& out) const {
-  out << "digraph segmentation_tree {" << std::endl;
-  out << "node [shape=record, fontname=\"Arial\"]" << std::endl;
-  for (const auto& iter : nodes_) {
-    auto& morph_string = iter.first;
-    auto& node = iter.second;
-    //out << node.count << " " << morph_string << std::endl;
-    out << "\"" << morph_string << "\" [label=\"" << morph_string << "| "
-        << node.count << "\"]" << std::endl;
-    if (node.left_child != "") {
-      out << "\"" << morph_string << "\" -> \""
-          << node.left_child << "\"" << std::endl;
+std::ostream& Segmentation::print_tree(std::ostream& out,
+    const OutputOptions& options) const {
+  // Morph strings never contain whitespace, since the corpus is split on it.
+  auto entries = OutputNodes(false, options.sorted);
+  OutputBuffer buffer{out};
+  WriteChunks(buffer, entries.size(),
+      [&entries](size_t begin, size_t end, std::string& text) {
+        char digits[20];
+        auto digits_end = digits + sizeof(digits);
+        for (auto i = begin; i < end; ++i) {
+          const auto& node = entries[i]->second;
+          text.append(FormatDecimal(node.count, digits_end), digits_end);
+          text += ' ';
+          text.append(entries[i]->first.begin(), entries[i]->first.end());
+          if (node.has_children()) {
+            text += ' ';
+            text += node.left_child;
+            text += ' ';
+            text += node.right_child;
+          }
+          text += '\n';
+        }
+      }, options.threads);
+  buffer.Flush();
+  return out;
+}
+
+std::vector<const Segmentation::NodeEntry*> Segmentation::DotNodes(
+    const DotFilter& filter, bool sorted) const {
+  if (filter.empty()) {
+    return OutputNodes(false, sorted);
+  }
+
+  // Without a list of words, the trees start at the nodes that are not
+  // part of any other node.
+  std::vector<std::pair<const NodeEntry*, size_t> > pending;
+  if (filter.words.empty()) {
+    std::unordered_set<MorphKey> children;
+    for (const auto& iter : nodes_) {
+      if (iter.second.has_children()) {
+        children.insert(MorphKey::View(iter.second.left_child));
+        children.insert(MorphKey::View(iter.second.right_child));
+      }
+    }
+    for (const auto& iter : nodes_) {
+      if (children.find(iter.first) == children.end()) {
+        pending.emplace_back(&iter, 1);
+      }
+    }
+  } else {
+    for (const auto& word : filter.words) {
+      auto found = nodes_.find(MorphKey::View(word));
+      if (found != nodes_.end()) {
+        pending.emplace_back(&*found, 1);
+      }
     }
-    if (node.right_child != "") {
-      out << "\"" << morph_string << "\" -> \""
-          << node.right_child << "\"" << std::endl;
+  }
+
+  std::unordered_set<const NodeEntry*> drawn;
+  std::vector<const NodeEntry*> entries;
+  while (!pending.empty()) {
+    auto entry = pending.back().first;
+    auto depth = pending.back().second;
+    pending.pop_back();
+    if (entry->second.count < filter.min_count ||
+        !drawn.insert(entry).second) {
+      continue;
+    }
+    entries.push_back(entry);
+    const auto& node = entry->second;
+    if (node.has_children() &&
+        (filter.max_depth == 0 || depth < filter.max_depth)) {
+      pending.emplace_back(
+          &*nodes_.find(MorphKey::View(node.right_child)), depth + 1);
+      pending.emplace_back(
+          &*nodes_.find(MorphKey::View(node.left_child)), depth + 1);
+    }
+  }
+  if (sorted) {
+    std::sort(entries.begin(), entries.end(),
+        [](const NodeEntry* left, const NodeEntry* right) {
+          return left->first < right->first;
+        });
+  }
+  return entries;
+}
+
+std::ostream& Segmentation::print_dot(std::ostream& out,
+    const DotFilter& filter, const OutputOptions& options) const {
+  auto entries = DotNodes(filter, options.sorted);
+  // Edges only go to nodes that are drawn.
+  std::unordered_set<std::string> hidden;
+  if (!filter.empty()) {
+    std::unordered_set<const NodeEntry*> drawn(entries.begin(),
+        entries.end());
+    for (auto entry : entries) {
+      const auto& node = entry->second;
+      if (node.has_children()) {
+        for (const auto* child : {&node.left_child, &node.right_child}) {
+          if (!drawn.count(&*nodes_.find(MorphKey::View(*child)))) {
+            hidden.insert(*child);
+          }
+        }
+      }
     }
   }
-  out << "}" << std::endl;
+
+  OutputBuffer buffer{out};
+  buffer << "digraph segmentation_tree {\n"
+      << "node [shape=record, fontname=\"Arial\"]\n";
+  WriteChunks(buffer, entries.size(),
+      [&entries, &hidden](size_t begin, size_t end, std::string& text) {
+        char digits[20];
+        auto digits_end = digits + sizeof(digits);
+        // A quote or a backslash in a morph would end the string early.
+        auto append_escaped = [&text](const auto& morph) {
+          for (auto c : morph) {
+            if (c == '"' || c == '\\') {
+              text += '\\';
+            }
+            text += c;
+          }
+        };
+        for (auto i = begin; i < end; ++i) {
+          const auto& morph_string = entries[i]->first;
+          const auto& node = entries[i]->second;
+          text += '"';
+          append_escaped(morph_string);
+          text += "\" [label=\"";
+          append_escaped(morph_string);
+          text += "| ";
+          text.append(FormatDecimal(node.count, digits_end), digits_end);
+          text += "\"]\n";
+          for (const auto* child : {&node.left_child, &node.right_child}) {
+            if (!child->empty() && !hidden.count(*child)) {
+              text += '"';
+              append_escaped(morph_string);
+              text += "\" -> \"";
+              append_escaped(*child);
+              text += "\"\n";
+            }
+          }
+        }
+      }, options.threads);
+  buffer << "}\n";
+  buffer.Flush();
   return out;
 }
 
@@ -308,14 +968,22 @@ std::ostream& Segmentation::print_dot_debug() const {
   return print_dot(out);
 }
 
-std::ostream& Segmentation::print_as_corpus(std::ostream& out) const {
-  for (const auto& iter : nodes_) {
-    auto& morph_string = iter.first;
-    auto& node = iter.second;
-    if (!node.has_children()) {
-      out << node.count << " " << morph_string << std::endl;
-    }
+void AppendSegmentation(const std::string& word, const size_t* boundaries,
+    size_t morph_count, std::string& out) {
+  size_t start_index = 0;
+  for (size_t i = 0; i < morph_count; ++i) {
+    out.append(word, start_index, boundaries[i] - start_index);
+    out += ' ';
+    start_index = boundaries[i];
   }
 }
 
+std::ostream& Segmentation::print_as_corpus(std::ostream& out,
+    const OutputOptions& options) const {
+  OutputBuffer buffer{out};
+  PrintLeaves(buffer, options);
+  buffer.Flush();
+  return out;
+}
+
 } // namespace morfessor
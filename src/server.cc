@@ -0,0 +1,242 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "server.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace morfessor {
+
+namespace {
+
+// Maximum number of batches per client that are being segmented or are
+// waiting to be written. Stops a client that sends faster than it reads
+// from using up all the memory.
+constexpr size_t kMaxBatchesInFlight = 64;
+
+// Writes all of data to fd. Returns false if the other end is gone, which
+// write reports as EPIPE once SIGPIPE is ignored, or the write fails.
+bool WriteAll(int fd, const std::string& data) {
+  size_t written = 0;
+  auto is_socket = true;
+  while (written < data.size()) {
+    ssize_t result;
+    if (is_socket) {
+      // Don't let a client that hangs up kill the server with SIGPIPE.
+      result = send(fd, data.data() + written, data.size() - written,
+          MSG_NOSIGNAL);
+      if (result < 0 && errno == ENOTSOCK) {
+        is_socket = false;
+        continue;
+      }
+    } else {
+      result = write(fd, data.data() + written, data.size() - written);
+    }
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // EPIPE or any other error: the answers can no longer be delivered.
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+}  // namespace
+
+SegmentationServer::SegmentationServer(const Segmentation& segmentation,
+    size_t threads, size_t batch_size)
+    : segmentation_(segmentation), pool_(threads), batch_size_(batch_size) {
+  assert(batch_size > 0);
+}
+
+std::string SegmentationServer::SegmentBatch(
+    const std::vector<std::string>& words) const {
+  std::string lines;
+  Segmentation::DecodeBuffers buffers;
+  std::vector<size_t> boundaries;
+  for (const auto& word : words) {
+    if (boundaries.size() < word.length()) {
+      boundaries.resize(word.length());
+    }
+    auto morph_count = segmentation_.SegmentWord(word.data(), word.length(),
+        buffers, boundaries.data());
+    AppendSegmentation(word, boundaries.data(), morph_count, lines);
+    lines += '\n';
+  }
+  return lines;
+}
+
+void SegmentationServer::Serve(int in_fd, int out_fd) {
+  // Batches in the order they were read. The writer waits for each one to
+  // be segmented in turn, while the reader keeps adding more.
+  std::deque<std::future<std::string> > pending;
+  std::mutex mutex;
+  std::condition_variable changed;
+  auto input_ended = false;
+  auto output_closed = false;
+
+  std::thread writer([&]() {
+    while (true) {
+      std::future<std::string> batch;
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        changed.wait(lock, [&]() { return input_ended || !pending.empty(); });
+        if (pending.empty()) {
+          return;
+        }
+        batch = std::move(pending.front());
+        pending.pop_front();
+      }
+      changed.notify_all();
+      if (!WriteAll(out_fd, batch.get())) {
+        std::lock_guard<std::mutex> lock{mutex};
+        output_closed = true;
+        changed.notify_all();
+        return;
+      }
+    }
+  });
+
+  std::vector<std::string> batch;
+  // Hands the words read so far to the workers. Returns false once the
+  // client stops reading answers.
+  auto dispatch = [&]() {
+    if (batch.empty()) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock{mutex};
+    changed.wait(lock, [&]() {
+      return output_closed || pending.size() < kMaxBatchesInFlight;
+    });
+    if (output_closed) {
+      return false;
+    }
+    auto words = std::make_shared<std::vector<std::string> >();
+    words->swap(batch);
+    pending.push_back(pool_.Submit([this, words]() {
+      return SegmentBatch(*words);
+    }));
+    changed.notify_all();
+    return true;
+  };
+
+  std::string line;
+  char buffer[1 << 16];
+  auto open = true;
+  while (open) {
+    auto length = read(in_fd, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      break;
+    }
+    auto begin = buffer;
+    auto end = buffer + length;
+    while (auto newline = static_cast<char*>(
+        std::memchr(begin, '\n', end - begin))) {
+      line.append(begin, newline);
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      batch.push_back(std::move(line));
+      line.clear();
+      begin = newline + 1;
+      if (batch.size() == batch_size_ && !dispatch()) {
+        open = false;
+        break;
+      }
+    }
+    line.append(begin, end);
+    // Answer the words that have arrived without waiting for a full batch.
+    open = open && dispatch();
+  }
+  if (open && !line.empty()) {
+    batch.push_back(std::move(line));
+    dispatch();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    input_ended = true;
+  }
+  changed.notify_all();
+  writer.join();
+}
+
+void SegmentationServer::ListenUnix(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("socket path is too long: " + path);
+  }
+  path.copy(address.sun_path, path.size());
+
+  auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    throw std::system_error(errno, std::generic_category(), "socket");
+  }
+  unlink(path.c_str());
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address),
+          sizeof(address)) < 0 ||
+      listen(listener, SOMAXCONN) < 0) {
+    auto error = errno;
+    close(listener);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+
+  while (true) {
+    auto client = accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      auto error = errno;
+      close(listener);
+      throw std::system_error(error, std::generic_category(), "accept");
+    }
+    std::thread([this, client]() {
+      Serve(client, client);
+      close(client);
+    }).detach();
+  }
+}
+
+}  // namespace morfessor
@@ -0,0 +1,182 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sweep.h"
+
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <memory>
+
+#include "model.h"
+#include "segmentation.h"
+#include "thread_pool.h"
+
+namespace morfessor {
+
+namespace {
+
+bool explicit_frequency(AlgorithmModes mode) {
+  return mode == AlgorithmModes::kBaselineFreq ||
+      mode == AlgorithmModes::kBaselineFreqLength;
+}
+
+bool explicit_length(AlgorithmModes mode) {
+  return mode == AlgorithmModes::kBaselineLength ||
+      mode == AlgorithmModes::kBaselineFreqLength;
+}
+
+SweepResult Train(const Corpus& corpus, const LetterStatistics& letters,
+    const SweepConfiguration& configuration, const Corpus* test_corpus,
+    const GoldStandard* gold) {
+  auto start = std::chrono::steady_clock::now();
+  auto model = std::make_shared<Model>(corpus, letters, configuration.mode,
+      configuration.hapax, configuration.most_common_length,
+      configuration.beta);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+
+  SweepResult result;
+  result.configuration = configuration;
+  result.overall_cost = model->overall_cost();
+  result.lexicon_cost = model->lexicon_cost();
+  result.corpus_cost = model->corpus_cost();
+  result.unique_morph_types = model->unique_morph_types();
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (test_corpus && gold) {
+    // The other trainings keep the rest of the threads busy.
+    result.score = Evaluate(segmentation, *test_corpus, *gold, 1);
+    result.evaluated = true;
+  }
+  return result;
+}
+
+}  // namespace
+
+std::vector<SweepConfiguration> MakeSweepGrid(
+    const std::vector<AlgorithmModes>& modes,
+    const std::vector<double>& hapaxes,
+    const std::vector<double>& most_common_lengths,
+    const std::vector<double>& betas) {
+  // Parameters a mode does not use keep their first value.
+  const std::vector<double> default_hapax{
+      hapaxes.empty() ? SweepConfiguration{}.hapax : hapaxes.front()};
+  const std::vector<double> default_length{most_common_lengths.empty()
+      ? SweepConfiguration{}.most_common_length
+      : most_common_lengths.front()};
+  const std::vector<double> default_beta{
+      betas.empty() ? SweepConfiguration{}.beta : betas.front()};
+
+  std::vector<SweepConfiguration> grid;
+  for (auto mode : modes) {
+    const auto& mode_hapaxes = explicit_frequency(mode) && !hapaxes.empty()
+        ? hapaxes : default_hapax;
+    const auto& mode_lengths =
+        explicit_length(mode) && !most_common_lengths.empty()
+        ? most_common_lengths : default_length;
+    const auto& mode_betas = explicit_length(mode) && !betas.empty()
+        ? betas : default_beta;
+    for (auto hapax : mode_hapaxes) {
+      for (auto length : mode_lengths) {
+        for (auto beta : mode_betas) {
+          SweepConfiguration configuration;
+          configuration.mode = mode;
+          configuration.hapax = hapax;
+          configuration.most_common_length = length;
+          configuration.beta = beta;
+          grid.push_back(configuration);
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+std::vector<SweepResult> Sweep(const Corpus& corpus,
+    const std::vector<SweepConfiguration>& configurations, size_t threads,
+    const Corpus* test_corpus, const GoldStandard* gold) {
+  const LetterStatistics letters{corpus, threads};
+  ThreadPool pool{threads};
+  std::vector<std::future<SweepResult> > futures;
+  futures.reserve(configurations.size());
+  for (const auto& configuration : configurations) {
+    futures.push_back(pool.Submit(
+        [&corpus, &letters, &configuration, test_corpus, gold]() {
+          return Train(corpus, letters, configuration, test_corpus, gold);
+        }));
+  }
+  std::vector<SweepResult> results;
+  results.reserve(futures.size());
+  for (auto& future : futures) {
+    results.push_back(future.get());
+  }
+  return results;
+}
+
+std::ostream& print_table(std::ostream& out,
+    const std::vector<SweepResult>& results) {
+  auto old_flags = out.flags();
+  auto old_precision = out.precision();
+  auto evaluated = false;
+  for (const auto& result : results) {
+    evaluated = evaluated || result.evaluated;
+  }
+
+  out << std::left << std::setw(11) << "mode" << std::right
+      << std::setw(7) << "hapax" << std::setw(8) << "length"
+      << std::setw(7) << "beta" << std::setw(16) << "overall_cost"
+      << std::setw(16) << "lexicon_cost" << std::setw(16) << "corpus_cost"
+      << std::setw(10) << "morphs" << std::setw(10) << "seconds";
+  if (evaluated) {
+    out << std::setw(10) << "F" << std::setw(10) << "precision"
+        << std::setw(10) << "recall";
+  }
+  out << "\n";
+
+  out << std::fixed;
+  for (const auto& result : results) {
+    const auto& configuration = result.configuration;
+    out << std::left << std::setw(11) << AlgorithmModeName(configuration.mode)
+        << std::right << std::setprecision(2)
+        << std::setw(7) << configuration.hapax
+        << std::setw(8) << configuration.most_common_length
+        << std::setw(7) << configuration.beta
+        << std::setprecision(3)
+        << std::setw(16) << result.overall_cost
+        << std::setw(16) << result.lexicon_cost
+        << std::setw(16) << result.corpus_cost
+        << std::setw(10) << result.unique_morph_types
+        << std::setprecision(2) << std::setw(10) << result.seconds;
+    if (result.evaluated) {
+      out << std::setw(9) << 100 * result.score.fmeasure() << "%"
+          << std::setw(9) << 100 * result.score.precision() << "%"
+          << std::setw(9) << 100 * result.score.recall() << "%";
+    }
+    out << "\n";
+  }
+  out.precision(old_precision);
+  out.flags(old_flags);
+  return out;
+}
+
+}  // namespace morfessor
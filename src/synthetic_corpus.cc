@@ -0,0 +1,169 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "synthetic_corpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace morfessor {
+
+namespace {
+
+// 64-bit FNV-1a. Unlike std::hash, it is the same on every platform and
+// standard library, so the same seed always skips the same words.
+uint64_t HashWord(const std::string& word) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char letter : word) {
+    hash ^= letter;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+SyntheticCorpusGenerator::SyntheticCorpusGenerator(
+    const SyntheticCorpusOptions& options)
+: options_{options},
+  morphs_{},
+  cumulative_weights_{},
+  random_{options.seed}
+{
+  if (options_.alphabet.empty() || options_.morph_types == 0 ||
+      options_.min_morph_length == 0 ||
+      options_.min_morph_length > options_.max_morph_length) {
+    throw std::invalid_argument("no morphs can be generated");
+  }
+  // Refuse inventories that take too long to fill with distinct morphs.
+  double possible = 0;
+  for (auto length = options_.min_morph_length;
+      length <= options_.max_morph_length; ++length) {
+    possible += std::pow(options_.alphabet.size(), length);
+  }
+  if (possible < 2.0 * options_.morph_types) {
+    throw std::invalid_argument("too few letters for the morph inventory");
+  }
+  std::unordered_set<std::string> seen;
+  seen.reserve(options_.morph_types);
+  morphs_.reserve(options_.morph_types);
+  while (morphs_.size() < options_.morph_types) {
+    std::string morph(uniform(options_.min_morph_length,
+        options_.max_morph_length), ' ');
+    for (auto& letter : morph) {
+      letter = options_.alphabet[uniform(0, options_.alphabet.size() - 1)];
+    }
+    if (seen.insert(morph).second) {
+      morphs_.push_back(std::move(morph));
+    }
+  }
+  init();
+}
+
+SyntheticCorpusGenerator::SyntheticCorpusGenerator(
+    const SyntheticCorpusOptions& options, std::vector<std::string> morphs)
+: options_{options},
+  morphs_{std::move(morphs)},
+  cumulative_weights_{},
+  random_{options.seed}
+{
+  if (morphs_.empty()) {
+    throw std::invalid_argument("the morph inventory is empty");
+  }
+  init();
+}
+
+void SyntheticCorpusGenerator::init() {
+  if (options_.min_morphs == 0 ||
+      options_.min_morphs > options_.max_morphs) {
+    throw std::invalid_argument("bad number of morphs per word");
+  }
+  if (options_.max_count == 0) {
+    throw std::invalid_argument("max_count must be positive");
+  }
+  cumulative_weights_.reserve(morphs_.size());
+  double total = 0;
+  for (size_t rank = 1; rank <= morphs_.size(); ++rank) {
+    total += std::pow(rank, -options_.morph_exponent);
+    cumulative_weights_.push_back(total);
+  }
+}
+
+double SyntheticCorpusGenerator::uniform() {
+  // The top 53 bits fill the mantissa of a double exactly.
+  return (random_() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+size_t SyntheticCorpusGenerator::uniform(size_t low, size_t high) {
+  return low + static_cast<size_t>(uniform() * (high - low + 1));
+}
+
+void SyntheticCorpusGenerator::Generate(std::ostream& words,
+    std::ostream* gold) {
+  // Only a hash of each word is kept, so that vocabularies of many millions
+  // of words fit in memory. A collision just skips a word.
+  std::unordered_set<uint64_t> seen;
+  seen.reserve(options_.word_types);
+
+  // Give up when almost every word drawn is one we already have.
+  const size_t max_attempts = 100 * options_.word_types + 1000;
+  size_t attempts = 0;
+
+  std::string word;
+  std::string segmentation;
+  size_t rank = 0;
+  while (rank < options_.word_types) {
+    if (++attempts > max_attempts) {
+      throw std::runtime_error("the morph inventory is too small for "
+          "that many distinct words");
+    }
+    word.clear();
+    segmentation.clear();
+    auto morph_count = uniform(options_.min_morphs, options_.max_morphs);
+    for (size_t i = 0; i < morph_count; ++i) {
+      auto target = uniform() * cumulative_weights_.back();
+      auto index = std::min<size_t>(morphs_.size() - 1,
+          std::upper_bound(cumulative_weights_.begin(),
+              cumulative_weights_.end(), target) -
+          cumulative_weights_.begin());
+      word += morphs_[index];
+      if (i > 0) {
+        segmentation += ' ';
+      }
+      segmentation += morphs_[index];
+    }
+    if (!seen.insert(HashWord(word)).second) {
+      continue;
+    }
+    ++rank;
+    auto count = std::max<size_t>(1, static_cast<size_t>(
+        options_.max_count * std::pow(rank, -options_.word_exponent)));
+    words << count << ' ' << word << '\n';
+    if (gold) {
+      *gold << word << '\t' << segmentation << '\n';
+    }
+  }
+}
+
+}  // namespace morfessor
@@ -0,0 +1,309 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "text_segmenter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace morfessor {
+
+namespace {
+
+// Bytes asked for by each read.
+constexpr size_t kReadSize = 1 << 16;
+
+// Blocks per worker that are being segmented or are waiting to be written.
+constexpr size_t kBlocksInFlightPerWorker = 4;
+
+// The cache is split into shards with a lock each, so that workers looking
+// up different tokens rarely wait for each other.
+constexpr size_t kCacheShards = 64;
+
+const char kWhitespace[] = " \t\n\v\f\r";
+
+bool IsWhitespace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Writes all of data to fd, or throws.
+void WriteAll(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    auto result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "write");
+    }
+    written += result;
+  }
+}
+
+// A segmented block.
+struct SegmentedBlock {
+  std::string text;
+  size_t tokens = 0;
+  size_t decoded = 0;
+};
+
+}  // namespace
+
+/// Segmentations of tokens, shared by the workers.
+class TextSegmenter::Cache {
+ public:
+  /// C'tor.
+  /// @param capacity Maximum number of tokens to remember.
+  explicit Cache(size_t capacity)
+      : shard_capacity_((capacity + kCacheShards - 1) / kCacheShards) {}
+
+  /// Appends the segmentation of a token to out if it is known.
+  /// @return true if it was.
+  bool Find(const std::string& token, std::string& out) {
+    auto& shard = shard_of(token);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto found = shard.segmentations.find(token);
+    if (found == shard.segmentations.end()) {
+      return false;
+    }
+    out += found->second;
+    return true;
+  }
+
+  /// Remembers the segmentation of a token, unless the cache is full.
+  void Insert(const std::string& token, const std::string& segmented) {
+    auto& shard = shard_of(token);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    if (shard.segmentations.size() < shard_capacity_) {
+      shard.segmentations.emplace(token, segmented);
+    }
+  }
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> segmentations;
+  };
+
+  Shard& shard_of(const std::string& token) {
+    // The low bits pick the bucket within the shard's own table.
+    return shards_[(std::hash<std::string>()(token) >> 16) % kCacheShards];
+  }
+
+  Shard shards_[kCacheShards];
+  size_t shard_capacity_;
+};
+
+TextSegmenter::TextSegmenter(const Segmentation& segmentation,
+    const std::string& separator, size_t threads, size_t block_size,
+    size_t cache_size)
+    : segmentation_(segmentation), separator_(separator),
+      block_size_(block_size), cache_(new Cache{cache_size}),
+      pool_(threads) {
+  assert(block_size > 0);
+}
+
+TextSegmenter::~TextSegmenter() = default;
+
+std::pair<size_t, size_t> TextSegmenter::SegmentBlock(const char* text,
+    size_t length, std::string& out) {
+  Segmentation::DecodeBuffers buffers;
+  std::vector<size_t> boundaries;
+  std::string token;
+  std::string segmented;
+  size_t tokens = 0;
+  size_t decoded = 0;
+
+  auto end = text + length;
+  auto next = text;
+  while (next != end) {
+    auto start = next;
+    while (next != end && IsWhitespace(*next)) {
+      ++next;
+    }
+    out.append(start, next);
+    if (next == end) {
+      break;
+    }
+    start = next;
+    while (next != end && !IsWhitespace(*next)) {
+      ++next;
+    }
+    token.assign(start, next);
+    ++tokens;
+    if (cache_->Find(token, out)) {
+      continue;
+    }
+
+    ++decoded;
+    if (boundaries.size() < token.length()) {
+      boundaries.resize(token.length());
+    }
+    auto morph_count = segmentation_.SegmentWord(token.data(),
+        token.length(), buffers, boundaries.data());
+    segmented.clear();
+    size_t start_index = 0;
+    for (size_t i = 0; i < morph_count; ++i) {
+      if (i > 0) {
+        segmented += separator_;
+      }
+      segmented.append(token, start_index, boundaries[i] - start_index);
+      start_index = boundaries[i];
+    }
+    out += segmented;
+    cache_->Insert(token, segmented);
+  }
+  return std::make_pair(tokens, decoded);
+}
+
+TextStats TextSegmenter::Segment(int in_fd, int out_fd) {
+  TextStats stats;
+  // Blocks in the order they were read. The writer waits for each one to
+  // be segmented in turn, while the reader keeps adding more.
+  std::deque<std::future<SegmentedBlock> > pending;
+  std::mutex mutex;
+  std::condition_variable changed;
+  auto input_ended = false;
+  std::exception_ptr output_error;
+  const auto max_in_flight = kBlocksInFlightPerWorker * pool_.size();
+
+  std::thread writer([&]() {
+    while (true) {
+      std::future<SegmentedBlock> future;
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        changed.wait(lock, [&]() { return input_ended || !pending.empty(); });
+        if (pending.empty()) {
+          return;
+        }
+        future = std::move(pending.front());
+        pending.pop_front();
+      }
+      changed.notify_all();
+      try {
+        auto block = future.get();
+        WriteAll(out_fd, block.text);
+        stats.tokens += block.tokens;
+        stats.decoded += block.decoded;
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{mutex};
+        output_error = std::current_exception();
+        changed.notify_all();
+        return;
+      }
+    }
+  });
+
+  // Hands a block to the workers. Returns false once the writer has
+  // failed.
+  auto dispatch = [&](std::shared_ptr<std::string> block) {
+    std::unique_lock<std::mutex> lock{mutex};
+    changed.wait(lock, [&]() {
+      return output_error || pending.size() < max_in_flight;
+    });
+    if (output_error) {
+      return false;
+    }
+    pending.push_back(pool_.Submit([this, block]() {
+      SegmentedBlock segmented;
+      // Most tokens get a separator or two longer.
+      segmented.text.reserve(block->size() + block->size() / 2);
+      std::tie(segmented.tokens, segmented.decoded) =
+          SegmentBlock(block->data(), block->size(), segmented.text);
+      return segmented;
+    }));
+    changed.notify_all();
+    return true;
+  };
+
+  auto read_error = 0;
+  auto open = true;
+  auto block = std::make_shared<std::string>();
+  block->reserve(block_size_ + kReadSize);
+  while (open) {
+    auto old_size = block->size();
+    block->resize(old_size + kReadSize);
+    auto length = read(in_fd, &(*block)[old_size], kReadSize);
+    block->resize(old_size + std::max<ssize_t>(length, 0));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      read_error = errno;
+      break;
+    } else if (length == 0) {
+      break;
+    }
+    stats.bytes += length;
+    if (block->size() < block_size_) {
+      continue;
+    }
+    // Cut after the last whitespace, and keep reading if a token is longer
+    // than a whole block.
+    auto cut = block->find_last_of(kWhitespace);
+    if (cut == std::string::npos) {
+      continue;
+    }
+    auto rest = std::make_shared<std::string>();
+    rest->reserve(block_size_ + kReadSize);
+    rest->assign(*block, cut + 1, std::string::npos);
+    block->resize(cut + 1);
+    open = dispatch(std::move(block));
+    block = std::move(rest);
+  }
+  if (open && !block->empty()) {
+    dispatch(std::move(block));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    input_ended = true;
+  }
+  changed.notify_all();
+  writer.join();
+
+  if (output_error) {
+    std::rethrow_exception(output_error);
+  }
+  if (read_error != 0) {
+    throw std::system_error(read_error, std::generic_category(), "read");
+  }
+  return stats;
+}
+
+}  // namespace morfessor
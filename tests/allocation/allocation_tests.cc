@@ -0,0 +1,260 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Allocation budgets for the hot paths. This is a program of its own since
+// it replaces the global operator new to count allocations.
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "instrumentation.h"
+#include "model.h"
+#include "segmentation.h"
+#include "../corpus_loader.h"
+
+using Counter = morfessor::instrumentation::Counter;
+using Segmentation = morfessor::Segmentation;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+  ++allocations;
+  if (auto memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+
+// Counts the allocations made while it is alive.
+class AllocationCounter {
+ public:
+  AllocationCounter() : start_(allocations.load()) {}
+
+  size_t count() const { return allocations.load() - start_; }
+
+ private:
+  size_t start_;
+};
+
+class AllocationTests : public ::testing::Test {
+ protected:
+  AllocationTests()
+      : corpus_(corpus_loader().corpus3),
+        model_(std::make_shared<morfessor::BaselineModel>(corpus_)),
+        segmentation_(corpus_, model_) {
+    for (auto iter = corpus_.cbegin(); iter != corpus_.cend(); ++iter) {
+      words_.push_back(iter->letters());
+    }
+    // A fixed seed, so that every run checks the same lexicon.
+    segmentation_.set_seed(1);
+    segmentation_.Optimize();
+  }
+
+  void TearDown() override {
+    morfessor::instrumentation::Enable(false);
+    morfessor::instrumentation::Reset();
+  }
+
+  const morfessor::Corpus& corpus_;
+  std::shared_ptr<morfessor::Model> model_;
+  Segmentation segmentation_;
+  std::vector<std::string> words_;
+};
+
+// Adds and removes every word twice, and returns the allocations made
+// the second time.
+static size_t AdjustEveryWordTwice(Segmentation& segmentation,
+    const std::vector<std::string>& words) {
+  // The first pass grows the buffers that are kept between calls.
+  for (const auto& word : words) {
+    segmentation.AdjustMorphCount(word, 1);
+    segmentation.AdjustMorphCount(word, -1);
+  }
+
+  AllocationCounter counter;
+  for (const auto& word : words) {
+    segmentation.AdjustMorphCount(word, 1);
+    segmentation.AdjustMorphCount(word, -1);
+  }
+  return counter.count();
+}
+
+TEST_F(AllocationTests, AdjustMorphCountAllocatesNothing) {
+  EXPECT_EQ(0u, AdjustEveryWordTwice(segmentation_, words_));
+}
+
+TEST_F(AllocationTests, AdjustMorphCountAllocatesNothingWithSeed18) {
+  // The same check against the lexicon of another training run, whose
+  // split trees, and so the buffers AdjustMorphCount needs for them, differ
+  // from those of the fixture's lexicon.
+  Segmentation segmentation{corpus_,
+      std::make_shared<morfessor::BaselineModel>(corpus_)};
+  segmentation.set_seed(18);
+  segmentation.Optimize();
+  EXPECT_EQ(0u, AdjustEveryWordTwice(segmentation, words_));
+}
+
+TEST_F(AllocationTests, ResplitNodeOnlyAllocatesNewNodes) {
+  for (const auto& word : words_) {
+    if (segmentation_.contains(word)) {
+      segmentation_.ResplitNode(word);
+    }
+  }
+
+  morfessor::instrumentation::Enable();
+  morfessor::instrumentation::Reset();
+  AllocationCounter counter;
+  for (const auto& word : words_) {
+    if (segmentation_.contains(word)) {
+      segmentation_.ResplitNode(word);
+    }
+  }
+  auto count = counter.count();
+  auto inserts = morfessor::instrumentation::value(Counter::kNodeInserts);
+  morfessor::instrumentation::Enable(false);
+
+  // A new node needs its hash table entry. Its key views the letters of
+  // the word it came from, so nothing else is allocated.
+  EXPECT_LT(0u, inserts);
+  EXPECT_LE(count, inserts);
+}
+
+TEST_F(AllocationTests, SegmentWordAllocatesNothing) {
+  Segmentation::DecodeBuffers buffers;
+  std::vector<size_t> boundaries(64);
+  for (const auto& word : words_) {
+    segmentation_.SegmentWord(word.data(), word.length(), buffers,
+        boundaries.data());
+  }
+
+  AllocationCounter counter;
+  for (const auto& word : words_) {
+    segmentation_.SegmentWord(word.data(), word.length(), buffers,
+        boundaries.data());
+  }
+  auto count = counter.count();
+  EXPECT_EQ(0u, count);
+}
+
+TEST_F(AllocationTests, SegmentTestCorpusOnlyAllocatesOutput) {
+  AllocationCounter counter;
+  auto segmentations = segmentation_.SegmentTestCorpus(corpus_);
+  auto count = counter.count();
+
+  // The shared vector and its storage, the decode buffers, and the morph
+  // buffer and output strings that are too long to be stored inline.
+  size_t budget = 5;
+  for (const auto& word : words_) {
+    if (word.length() > std::string().capacity()) {
+      ++budget;
+      break;
+    }
+  }
+  for (const auto& segmentation : *segmentations) {
+    if (segmentation.capacity() > std::string().capacity()) {
+      ++budget;
+    }
+  }
+  EXPECT_LE(count, budget);
+}
+
+TEST_F(AllocationTests, SegmentTestCorpusSinkAllocatesOnlyBuffers) {
+  size_t morphs = 0;
+  AllocationCounter counter;
+  segmentation_.SegmentTestCorpus(corpus_, [&morphs](const std::string&,
+      const size_t*, size_t morph_count) {
+    morphs += morph_count;
+  });
+  auto count = counter.count();
+
+  // The decode buffers, the morph buffer and the boundaries, however many
+  // words there are.
+  EXPECT_LE(count, 4u);
+  EXPECT_GE(morphs, corpus_.size());
+}
+
+TEST_F(AllocationTests, CorpusOnlyAllocatesWords) {
+  std::string text;
+  for (const auto& word : words_) {
+    text += "3 " + word + "\n";
+  }
+  std::istringstream in{text};
+
+  AllocationCounter counter;
+  morfessor::Corpus corpus{in};
+  auto count = counter.count();
+
+  // The vector grows by doubling, and a word is only copied to the heap
+  // when it is too long to be stored inline. The rest is the line buffer
+  // and the shared holder of the words.
+  size_t budget = 4;
+  for (size_t capacity = 1; capacity < words_.size(); capacity *= 2) {
+    ++budget;
+  }
+  for (const auto& word : words_) {
+    if (word.length() > std::string().capacity()) {
+      ++budget;
+    }
+  }
+  ASSERT_EQ(words_.size(), corpus.size());
+  EXPECT_LE(count, budget);
+}
+
+TEST_F(AllocationTests, ConstructionOnlyAllocatesOwnedStructures) {
+  AllocationCounter model_counter;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus_);
+  auto model_count = model_counter.count();
+
+  // The letter tables, however many words there are.
+  size_t letters = model->letter_statistics().counts.size();
+  EXPECT_LE(model_count, 2 * letters + 8);
+
+  AllocationCounter segmentation_counter;
+  Segmentation segmentation{corpus_, model};
+  auto segmentation_count = segmentation_counter.count();
+
+  // One hash table entry per word, the bucket array each time it grows,
+  // and the list of corpora whose words the keys view. The words
+  // themselves are shared with the corpus.
+  size_t budget = words_.size() + 3;
+  for (size_t buckets = 1; buckets < words_.size(); buckets *= 2) {
+    ++budget;
+  }
+  EXPECT_LE(segmentation_count, budget);
+}
@@ -0,0 +1,124 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morfessor.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+static const char* model_path = "../testdata/test3.txt";
+
+// Segments words with the C interface, and returns the morph ends of each.
+static std::vector<std::vector<size_t> > segment(
+    const morfessor_model* model, const std::vector<std::string>& words) {
+  std::vector<const char*> letters;
+  std::vector<size_t> lengths;
+  size_t total_length = 0;
+  for (const auto& word : words) {
+    letters.push_back(word.data());
+    lengths.push_back(word.size());
+    total_length += word.size();
+  }
+  std::vector<size_t> boundaries(total_length);
+  std::vector<size_t> offsets(words.size() + 1);
+  EXPECT_EQ(MORFESSOR_OK, morfessor_segment(model, letters.data(),
+      lengths.data(), words.size(), boundaries.data(), boundaries.size(),
+      offsets.data()));
+
+  std::vector<std::vector<size_t> > segmentations;
+  for (size_t i = 0; i < words.size(); ++i) {
+    segmentations.emplace_back(boundaries.begin() + offsets[i],
+        boundaries.begin() + offsets[i + 1]);
+  }
+  return segmentations;
+}
+
+TEST(CApiTests, SegmentMatchesSegmentation) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus);
+  morfessor::Segmentation segmentation(corpus, model);
+
+  morfessor_model* loaded = nullptr;
+  ASSERT_EQ(MORFESSOR_OK, morfessor_load(model_path, nullptr, &loaded));
+
+  std::vector<std::string> words = {"reading", "", "walked", "x"};
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    words.push_back(iter->letters());
+  }
+  auto segmentations = segment(loaded, words);
+  for (size_t i = 0; i < words.size(); ++i) {
+    EXPECT_EQ(segmentation.SegmentWord(words[i]), segmentations[i]);
+  }
+  morfessor_free(loaded);
+}
+
+TEST(CApiTests, ConcurrentCallers) {
+  morfessor_model* loaded = nullptr;
+  ASSERT_EQ(MORFESSOR_OK, morfessor_load(model_path, nullptr, &loaded));
+  std::vector<std::string> words = {"reading", "walked", "redoing", "tried"};
+  auto expected = segment(loaded, words);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 100; ++j) {
+        EXPECT_EQ(expected, segment(loaded, words));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  morfessor_free(loaded);
+}
+
+TEST(CApiTests, Errors) {
+  morfessor_model* loaded = nullptr;
+  EXPECT_EQ(MORFESSOR_ERROR_IO,
+      morfessor_load("no-such-model.txt", nullptr, &loaded));
+  morfessor_options options;
+  morfessor_default_options(&options);
+  options.hapax = 1.5;
+  EXPECT_EQ(MORFESSOR_ERROR_INVALID_ARGUMENT,
+      morfessor_load(model_path, &options, &loaded));
+  EXPECT_EQ(nullptr, loaded);
+
+  ASSERT_EQ(MORFESSOR_OK, morfessor_load(model_path, nullptr, &loaded));
+  const char* words[] = {"reading"};
+  size_t lengths[] = {7};
+  size_t boundaries[6];
+  size_t offsets[2];
+  EXPECT_EQ(MORFESSOR_ERROR_BUFFER_TOO_SMALL, morfessor_segment(loaded,
+      words, lengths, 1, boundaries, 6, offsets));
+  morfessor_free(loaded);
+}
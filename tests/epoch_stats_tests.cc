@@ -0,0 +1,57 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "epoch_stats.h"
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+using EpochStats = morfessor::EpochStats;
+
+TEST(EpochStatsTests, PrintJson) {
+  EpochStats stats;
+  stats.epoch = 3;
+  stats.overall_cost = 150.5;
+  stats.lexicon_cost = 50.25;
+  stats.corpus_cost = 100.25;
+  stats.cost_delta = 2;
+  stats.convergence_threshold = 0.5;
+  stats.unique_morph_types = 100;
+  stats.total_morph_tokens = 4000;
+  stats.words_resplit = 120;
+  stats.seconds = 0.5;
+
+  std::stringstream out;
+  morfessor::print_json(out, stats);
+  EXPECT_EQ("{\"epoch\":3,\"overall_cost\":150.5,\"lexicon_cost\":50.25,"
+      "\"corpus_cost\":100.25,\"cost_delta\":2,\"convergence_threshold\":0.5,"
+      "\"unique_morph_types\":100,\"total_morph_tokens\":4000,"
+      "\"words_resplit\":120,\"words_per_second\":240,\"seconds\":0.5}",
+      out.str());
+}
+
+TEST(EpochStatsTests, NoTimeElapsed) {
+  EpochStats stats;
+  stats.words_resplit = 10;
+  EXPECT_EQ(0, stats.words_per_second());
+}
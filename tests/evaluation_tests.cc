@@ -0,0 +1,147 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "evaluation.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "corpus_loader.h"
+
+using BaselineModel = morfessor::BaselineModel;
+using BoundaryScore = morfessor::BoundaryScore;
+using GoldStandard = morfessor::GoldStandard;
+using Segmentation = morfessor::Segmentation;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+static GoldStandard make_gold(const std::string& lines) {
+  std::istringstream in{lines};
+  return GoldStandard{in};
+}
+
+TEST(EvaluationTests, CountsHitsInsertionsAndDeletions) {
+  auto gold = make_gold("walking\twalk ing\n"
+                        "houses\thouse s\n"
+                        "cat\tcat\n");
+  EXPECT_EQ(3, gold.size());
+
+  auto score = gold.Score("walk ing ");
+  EXPECT_EQ(1, score.hits);
+  EXPECT_EQ(0, score.insertions);
+  EXPECT_EQ(0, score.deletions);
+
+  score = gold.Score("hou se s ");
+  EXPECT_EQ(1, score.hits);
+  EXPECT_EQ(1, score.insertions);
+  EXPECT_EQ(0, score.deletions);
+
+  score = gold.Score("houses ");
+  EXPECT_EQ(0, score.hits);
+  EXPECT_EQ(0, score.insertions);
+  EXPECT_EQ(1, score.deletions);
+  EXPECT_EQ(1, score.evaluated_words);
+
+  score = gold.Score("dog ");
+  EXPECT_EQ(0, score.evaluated_words);
+  EXPECT_EQ(1, score.segmented_words);
+}
+
+TEST(EvaluationTests, UsesTheBestAlternative) {
+  auto gold = make_gold("aidasta\taida sta, aidas ta\n");
+  auto score = gold.Score("aidas ta");
+  EXPECT_EQ(1, score.hits);
+  EXPECT_EQ(0, score.insertions);
+  EXPECT_EQ(0, score.deletions);
+
+  // Against "aida sta" every boundary would be wrong.
+  score = gold.Score("aid as ta");
+  EXPECT_EQ(1, score.hits);
+  EXPECT_EQ(1, score.insertions);
+  EXPECT_EQ(0, score.deletions);
+}
+
+TEST(EvaluationTests, ComputesTheSameMetricsAsThePerlScript) {
+  BoundaryScore score;
+  score.hits = 3;
+  score.insertions = 1;
+  score.deletions = 2;
+  EXPECT_DOUBLE_EQ(0.75, score.precision());
+  EXPECT_DOUBLE_EQ(0.6, score.recall());
+  EXPECT_DOUBLE_EQ(6.0 / 9.0, score.fmeasure());
+
+  BoundaryScore empty;
+  EXPECT_DOUBLE_EQ(1, empty.precision());
+  EXPECT_DOUBLE_EQ(1, empty.recall());
+  EXPECT_DOUBLE_EQ(1, empty.fmeasure());
+
+  std::ostringstream out;
+  morfessor::print_table(out, score);
+  EXPECT_NE(std::string::npos, out.str().find("F-measure:  66.67%\n"));
+  EXPECT_NE(std::string::npos, out.str().find("Precision:  75.00%\n"));
+  EXPECT_NE(std::string::npos, out.str().find("Recall:     60.00%\n"));
+}
+
+TEST(EvaluationTests, RejectsInvalidGoldStandards) {
+  EXPECT_THROW(make_gold("walking walk ing\n"), std::runtime_error);
+  EXPECT_THROW(make_gold("walking\twalk ed\n"), std::runtime_error);
+  EXPECT_THROW(make_gold("walking\twalk ing, \n"), std::runtime_error);
+  EXPECT_THROW(GoldStandard{"no/such/gold/standard.txt"},
+      std::runtime_error);
+}
+
+TEST(EvaluationTests, MatchesScoringTheSegmentedTestCorpus) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+
+  // A gold standard that splits every word after its first two letters.
+  std::string lines;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    const auto& word = iter->letters();
+    lines += word + "\t";
+    lines += word.size() > 2
+        ? word.substr(0, 2) + " " + word.substr(2) : word;
+    lines += "\n";
+  }
+  auto gold = make_gold(lines);
+
+  BoundaryScore expected;
+  auto segments = segmentation.SegmentTestCorpus(corpus);
+  for (const auto& line : *segments) {
+    expected += gold.Score(line);
+  }
+  for (size_t threads : {1, 4}) {
+    auto score = morfessor::Evaluate(segmentation, corpus, gold, threads);
+    EXPECT_EQ(expected.hits, score.hits);
+    EXPECT_EQ(expected.insertions, score.insertions);
+    EXPECT_EQ(expected.deletions, score.deletions);
+    EXPECT_EQ(corpus.size(), score.evaluated_words);
+    EXPECT_EQ(corpus.size(), score.segmented_words);
+  }
+}
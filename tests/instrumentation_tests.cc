@@ -0,0 +1,112 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "instrumentation.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+namespace instrumentation = morfessor::instrumentation;
+using Counter = instrumentation::Counter;
+using Phase = instrumentation::Phase;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+class InstrumentationTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    instrumentation::Reset();
+  }
+
+  void TearDown() override {
+    instrumentation::Enable(false);
+    instrumentation::Reset();
+  }
+};
+
+TEST_F(InstrumentationTests, DisabledCountsNothing) {
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus);
+  morfessor::Segmentation segmentation(corpus, model);
+  segmentation.AdjustMorphCount("redoing", 1);
+  {
+    instrumentation::PhaseTimer timer{Phase::kLoad};
+  }
+  EXPECT_EQ(0u, instrumentation::value(Counter::kAdjustMorphCountCalls));
+  EXPECT_EQ(0, instrumentation::seconds(Phase::kLoad));
+}
+
+TEST_F(InstrumentationTests, CountsHotPaths) {
+  instrumentation::Enable();
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus);
+  morfessor::Segmentation segmentation(corpus, model);
+
+  segmentation.AdjustMorphCount("redoing", -2);
+  segmentation.AdjustMorphCount("re", 2);
+  EXPECT_EQ(2u, instrumentation::value(Counter::kAdjustMorphCountCalls));
+  EXPECT_EQ(2u, instrumentation::value(Counter::kAdjustMorphCountNodes));
+  EXPECT_EQ(1u, instrumentation::value(Counter::kNodeInserts));
+  EXPECT_EQ(1u, instrumentation::value(Counter::kNodeErases));
+
+  segmentation.SegmentWord("redo");
+  EXPECT_EQ(1u, instrumentation::value(Counter::kViterbiWords));
+  // One cell for each substring of the word.
+  EXPECT_EQ(10u, instrumentation::value(Counter::kViterbiCells));
+
+  auto lookups = instrumentation::value(Counter::kNodeLookups);
+  segmentation.ResplitNode("re");
+  EXPECT_EQ(1u, instrumentation::value(Counter::kResplitNodeCalls));
+  EXPECT_EQ(1u, instrumentation::value(Counter::kSplitCandidates));
+  // "re" stays whole: one lookup for its key and two of its own, plus one
+  // for each of the four AdjustMorphCount calls that try "r" + "e". The
+  // walks below those morphs follow links.
+  EXPECT_EQ(lookups + 3 + 4, instrumentation::value(Counter::kNodeLookups));
+}
+
+TEST_F(InstrumentationTests, Summary) {
+  instrumentation::Enable();
+  instrumentation::Count(Counter::kResplitNodeCalls, 2);
+  instrumentation::Count(Counter::kSplitCandidates, 5);
+  instrumentation::CountMax(Counter::kAdjustMorphCountMaxStack, 3);
+  instrumentation::CountMax(Counter::kAdjustMorphCountMaxStack, 2);
+  instrumentation::AddTime(Phase::kOptimize, std::chrono::milliseconds(1500));
+
+  std::stringstream json;
+  instrumentation::print_json(json);
+  EXPECT_NE(std::string::npos, json.str().find(
+      "\"adjust_morph_count_max_stack\":3,"));
+  EXPECT_NE(std::string::npos, json.str().find(
+      "\"split_candidates_per_resplit_node\":2.5,"));
+  EXPECT_NE(std::string::npos, json.str().find(
+      "\"optimize_seconds\":1.5,"));
+
+  std::stringstream table;
+  instrumentation::print_table(table);
+  EXPECT_NE(std::string::npos, table.str().find("resplit_node_calls"));
+}
@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lexicon_snapshot.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+using BaselineModel = morfessor::BaselineModel;
+using LexiconSnapshot = morfessor::LexiconSnapshot;
+using Segmentation = morfessor::Segmentation;
+using SnapshotPublisher = morfessor::SnapshotPublisher;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+static std::unique_ptr<const LexiconSnapshot> snapshot(size_t epoch) {
+  std::unordered_map<std::string, morfessor::Cost> morph_costs{{"a", 1}};
+  return std::unique_ptr<const LexiconSnapshot>(
+      new LexiconSnapshot(morph_costs, 1, epoch));
+}
+
+TEST(LexiconSnapshotTests, SegmentsLikeSegmentation) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+  auto lexicon = segmentation.Snapshot();
+
+  std::vector<std::string> words = {"reading", "walked", "", "x"};
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    words.push_back(iter->letters());
+  }
+  for (const auto& word : words) {
+    EXPECT_EQ(segmentation.SegmentWord(word), lexicon->SegmentWord(word));
+  }
+}
+
+TEST(LexiconSnapshotTests, ReaderKeepsSnapshotAlive) {
+  SnapshotPublisher publisher(2);
+  publisher.Publish(snapshot(1));
+  {
+    SnapshotPublisher::Reader reader(publisher);
+    EXPECT_EQ(1u, reader.Acquire()->epoch());
+    publisher.Publish(snapshot(2));
+    EXPECT_EQ(1u, publisher.retired());
+    reader.Release();
+    publisher.Reclaim();
+    EXPECT_EQ(0u, publisher.retired());
+    EXPECT_EQ(2u, reader.Acquire()->epoch());
+  }
+  publisher.Publish(snapshot(3));
+  EXPECT_EQ(0u, publisher.retired());
+}
+
+TEST(LexiconSnapshotTests, TooManyReaders) {
+  SnapshotPublisher publisher(1);
+  SnapshotPublisher::Reader reader(publisher);
+  EXPECT_EQ(nullptr, reader.Acquire());
+  EXPECT_THROW(SnapshotPublisher::Reader{publisher}, std::runtime_error);
+}
+
+TEST(LexiconSnapshotTests, ReadWhileTraining) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  auto publisher = std::make_shared<SnapshotPublisher>();
+  segmentation.set_snapshot_publisher(publisher);
+  size_t epochs = 0;
+  segmentation.set_epoch_callback([&epochs](const morfessor::EpochStats&) {
+    ++epochs;
+  });
+
+  std::atomic<bool> training{true};
+  std::thread reader_thread([&]() {
+    SnapshotPublisher::Reader reader(*publisher);
+    size_t last_epoch = 0;
+    while (training) {
+      auto lexicon = reader.Acquire();
+      if (lexicon != nullptr) {
+        EXPECT_LE(last_epoch, lexicon->epoch());
+        last_epoch = lexicon->epoch();
+        auto boundaries = lexicon->SegmentWord("reading");
+        ASSERT_FALSE(boundaries.empty());
+        EXPECT_EQ(7u, boundaries.back());
+      }
+      reader.Release();
+    }
+  });
+  segmentation.Optimize();
+  training = false;
+  reader_thread.join();
+
+  SnapshotPublisher::Reader reader(*publisher);
+  auto lexicon = reader.Acquire();
+  ASSERT_NE(nullptr, lexicon);
+  EXPECT_EQ(epochs, lexicon->epoch());
+  EXPECT_EQ(segmentation.SegmentWord("reading"),
+      lexicon->SegmentWord("reading"));
+}
@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "memory_usage.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+using MemoryUsage = morfessor::MemoryUsage;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+// Returns the bytes of one part of a data structure.
+static size_t part(const MemoryUsage& usage, const std::string& name) {
+  for (const auto& part : usage.parts) {
+    if (part.first == name) {
+      return part.second;
+    }
+  }
+  ADD_FAILURE() << "no part named " << name;
+  return 0;
+}
+
+TEST(MemoryUsageTests, HeapBytes) {
+  EXPECT_EQ(0u, morfessor::heap_bytes("short"));
+  std::string long_string(100, 'a');
+  EXPECT_EQ(long_string.capacity() + 1, morfessor::heap_bytes(long_string));
+}
+
+TEST(MemoryUsageTests, HashTableBytes) {
+  std::unordered_map<char, size_t> table{{'a', 1}, {'b', 2}};
+  using Value = std::unordered_map<char, size_t>::value_type;
+  EXPECT_EQ(2 * morfessor::hash_node_bytes<Value>() +
+      table.bucket_count() * sizeof(void*),
+      morfessor::hash_table_bytes(table));
+}
+
+TEST(MemoryUsageTests, Segmentation) {
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus);
+  morfessor::Segmentation segmentation(corpus, model);
+  auto before = segmentation.memory_usage();
+  // The words are shared with the corpus.
+  EXPECT_EQ(0u, part(before, "node_keys"));
+  EXPECT_EQ(0u, part(before, "child_strings"));
+  EXPECT_LT(0u, part(before, "buckets"));
+
+  // Splitting adds nodes for the children, and the parent stores copies of
+  // their names.
+  auto nodes = segmentation.size();
+  segmentation.AdjustMorphCount("redoingredoingredoing", 1);
+  segmentation.at("redoingredoingredoing").left_child =
+      "redoingredoingredoin";
+  segmentation.at("redoingredoingredoing").right_child = "g";
+  auto after = segmentation.memory_usage();
+  EXPECT_EQ(nodes + 1, segmentation.size());
+  EXPECT_LT(part(before, "nodes"), part(after, "nodes"));
+  EXPECT_LT(part(before, "node_keys"), part(after, "node_keys"));
+  EXPECT_LT(0u, part(after, "child_strings"));
+  EXPECT_EQ(after.total(), part(after, "node_keys") + part(after, "nodes") +
+      part(after, "buckets") + part(after, "child_strings") +
+      part(after, "optimizer_keys"));
+
+  EXPECT_LT(0u, part(corpus.memory_usage(), "words"));
+  EXPECT_LT(0u, part(model->memory_usage(), "letter_counts"));
+  EXPECT_LT(0u, morfessor::peak_rss_bytes());
+}
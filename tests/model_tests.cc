@@ -23,11 +23,14 @@
 #include "model.h"
 
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 
 #include <gtest/gtest.h>
 
 #include "corpus.h"
 #include "corpus_loader.h"
+#include "synthetic_corpus.h"
 
 using Model = morfessor::Model;
 using BaselineFrequencyModel = morfessor::BaselineFrequencyModel;
@@ -344,3 +347,130 @@ TEST_F(BaselineFrequencyLengthModelTests, LexiconOrderCost) {
 TEST_F(BaselineFrequencyLengthModelTests, IndividualLetterCosts) {
   check_explicit_letter_probabilities();
 }
+
+TEST(ModelTests, AdjustLeafCountsMatchesIndividualAdjustments) {
+  const auto& corpus = corpus_loader().corpus2;
+  BaselineFrequencyLengthModel batched(corpus);
+  BaselineFrequencyLengthModel individual(corpus);
+
+  std::vector<morfessor::MorphCountChange> changes{
+      {"walking", 2, 0}, {"walk", 0, 2}, {"ing", 0, 2}, {"relief", 8, 9}};
+  batched.adjust_leaf_counts(changes);
+
+  for (const auto& change : changes) {
+    int delta = change.new_count - change.old_count;
+    individual.adjust_morph_token_count(delta);
+    if (change.old_count > 0) {
+      individual.adjust_corpus_cost(-change.old_count);
+      individual.adjust_frequency_cost(-change.old_count);
+    }
+    if (change.new_count > 0) {
+      individual.adjust_corpus_cost(change.new_count);
+      individual.adjust_frequency_cost(change.new_count);
+    }
+    if (change.old_count == 0) {
+      individual.adjust_unique_morph_count(1);
+      individual.adjust_length_cost(change.morph.length());
+      individual.adjust_string_cost(change.morph, true);
+    } else if (change.new_count == 0) {
+      individual.adjust_unique_morph_count(-1);
+      individual.adjust_length_cost(-change.morph.length());
+      individual.adjust_string_cost(change.morph, false);
+    }
+  }
+
+  EXPECT_NEAR(individual.overall_cost(), batched.overall_cost(), threshold);
+  EXPECT_NEAR(individual.frequency_cost(), batched.frequency_cost(),
+      threshold);
+  EXPECT_NEAR(individual.length_cost(), batched.length_cost(), threshold);
+  EXPECT_NEAR(individual.morph_string_cost(), batched.morph_string_cost(),
+      threshold);
+  EXPECT_EQ(individual.total_morph_tokens(), batched.total_morph_tokens());
+  EXPECT_EQ(individual.unique_morph_types(), batched.unique_morph_types());
+}
+
+TEST(ModelTests, SharedLetterStatistics) {
+  const auto& corpus = corpus_loader().corpus3;
+  morfessor::LetterStatistics letters{corpus};
+  size_t letter_tokens = 0;
+  for (const auto& iter : letters.counts) {
+    letter_tokens += iter.second;
+  }
+  EXPECT_EQ(letters.total_letters, letter_tokens);
+
+  // Models made from letters counted once cost the same as models that
+  // count the letters themselves, whatever the algorithm.
+  BaselineFrequencyLengthModel counted(corpus, 0.3, 6.0, 1.5);
+  Model shared(corpus, letters,
+      morfessor::AlgorithmModes::kBaselineFreqLength, 0.3, 6.0, 1.5);
+  EXPECT_EQ(counted.overall_cost(), shared.overall_cost());
+  EXPECT_EQ(counted.letter_costs(), shared.letter_costs());
+  EXPECT_EQ(letters.total_letters,
+      shared.letter_statistics().total_letters);
+  EXPECT_EQ(letters.total_words, shared.letter_statistics().total_words);
+
+  BaselineModel baseline(corpus);
+  Model shared_baseline(corpus, letters, morfessor::AlgorithmModes::kBaseline,
+      0.5, 7.0, 1.0);
+  EXPECT_EQ(baseline.overall_cost(), shared_baseline.overall_cost());
+}
+
+TEST(ModelTests, ParallelInitialization) {
+  // Enough words for several chunks.
+  morfessor::SyntheticCorpusOptions options;
+  options.word_types = 150000;
+  options.morph_types = 3000;
+  std::stringstream words;
+  morfessor::SyntheticCorpusGenerator(options).Generate(words, nullptr);
+  Corpus corpus{words};
+
+  // The same costs, bit for bit, however many threads count them.
+  BaselineFrequencyLengthModel serial(corpus, 0.3, 6.0, 1.5, 1);
+  for (size_t threads : {2, 3, 0}) {
+    BaselineFrequencyLengthModel parallel(corpus, 0.3, 6.0, 1.5, threads);
+    EXPECT_EQ(serial.overall_cost(), parallel.overall_cost());
+    EXPECT_EQ(serial.frequency_cost(), parallel.frequency_cost());
+    EXPECT_EQ(serial.length_cost(), parallel.length_cost());
+    EXPECT_EQ(serial.morph_string_cost(), parallel.morph_string_cost());
+    EXPECT_EQ(serial.corpus_cost(), parallel.corpus_cost());
+    EXPECT_EQ(serial.letter_costs(), parallel.letter_costs());
+  }
+
+  // And the same as adding the words one at a time, up to rounding.
+  std::istringstream no_words;
+  Model one_at_a_time(Corpus{no_words}, serial.letter_statistics(),
+      morfessor::AlgorithmModes::kBaselineFreqLength, 0.3, 6.0, 1.5);
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    one_at_a_time.adjust_unique_morph_count(1);
+    one_at_a_time.adjust_morph_token_count(iter->frequency());
+    one_at_a_time.adjust_frequency_cost(iter->frequency());
+    one_at_a_time.adjust_string_cost(iter->letters(), true);
+    one_at_a_time.adjust_length_cost(iter->length());
+    one_at_a_time.adjust_corpus_cost(iter->frequency());
+  }
+  EXPECT_EQ(one_at_a_time.total_morph_tokens(), serial.total_morph_tokens());
+  EXPECT_EQ(one_at_a_time.unique_morph_types(), serial.unique_morph_types());
+  EXPECT_NEAR(1.0, serial.overall_cost() / one_at_a_time.overall_cost(),
+      1e-12);
+}
+
+TEST(ModelTests, ModeNames) {
+  // Each --mode value stands for the algorithm it is named after.
+  using AlgorithmModes = morfessor::AlgorithmModes;
+  EXPECT_EQ(AlgorithmModes::kBaseline,
+      morfessor::ParseAlgorithmMode("Baseline"));
+  EXPECT_EQ(AlgorithmModes::kBaselineFreq,
+      morfessor::ParseAlgorithmMode("Freq"));
+  EXPECT_EQ(AlgorithmModes::kBaselineLength,
+      morfessor::ParseAlgorithmMode("Length"));
+  EXPECT_EQ(AlgorithmModes::kBaselineFreqLength,
+      morfessor::ParseAlgorithmMode("FreqLength"));
+  for (auto mode : {AlgorithmModes::kBaseline, AlgorithmModes::kBaselineFreq,
+      AlgorithmModes::kBaselineLength, AlgorithmModes::kBaselineFreqLength}) {
+    EXPECT_EQ(mode,
+        morfessor::ParseAlgorithmMode(morfessor::AlgorithmModeName(mode)));
+  }
+  EXPECT_THROW(morfessor::ParseAlgorithmMode("baseline"),
+      std::invalid_argument);
+  EXPECT_THROW(morfessor::ParseAlgorithmMode(""), std::invalid_argument);
+}
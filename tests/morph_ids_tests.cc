@@ -0,0 +1,146 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morph_ids.h"
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+using MorphIdEncoding = morfessor::MorphIdEncoding;
+using Segmentation = morfessor::Segmentation;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+TEST(MorphIdsTests, VocabularyDecodesLikeTheSegmentation) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<morfessor::BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+  auto vocabulary = segmentation.Vocabulary();
+
+  ASSERT_EQ(segmentation.size() + 1, vocabulary->size());
+  EXPECT_EQ("", vocabulary->morph(morfessor::kUnknownMorphId));
+  for (uint32_t id = 1; id < vocabulary->size(); ++id) {
+    const auto& morph = vocabulary->morph(id);
+    EXPECT_EQ(segmentation.at(morph).count, vocabulary->count(id));
+    if (id > 1) {
+      // Most common first, then by bytes.
+      const auto& previous = vocabulary->morph(id - 1);
+      EXPECT_TRUE(vocabulary->count(id - 1) > vocabulary->count(id) ||
+          (vocabulary->count(id - 1) == vocabulary->count(id) &&
+              previous < morph)) << previous << " " << morph;
+    }
+  }
+
+  Segmentation::DecodeBuffers buffers;
+  std::vector<std::string> words{"xq"};
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    words.push_back(iter->letters() + "s");
+  }
+  for (const auto& word : words) {
+    std::vector<size_t> boundaries(word.length());
+    std::vector<uint32_t> ids(word.length());
+    auto morph_count = vocabulary->SegmentWord(word.data(), word.length(),
+        buffers, boundaries.data(), ids.data());
+    boundaries.resize(morph_count);
+    EXPECT_EQ(segmentation.SegmentWord(word), boundaries) << word;
+    size_t start_index = 0;
+    for (size_t i = 0; i < morph_count; ++i) {
+      auto morph = word.substr(start_index, boundaries[i] - start_index);
+      if (segmentation.contains(morph)) {
+        EXPECT_EQ(morph, vocabulary->morph(ids[i]));
+      } else {
+        EXPECT_EQ(morfessor::kUnknownMorphId, ids[i]);
+      }
+      start_index = boundaries[i];
+    }
+  }
+}
+
+static void check_round_trip(MorphIdEncoding encoding) {
+  const std::vector<std::vector<uint32_t> > words{
+      {1, 2, 3}, {}, {0, 127, 128, 300}, {1u << 21, 0xffffffffu}};
+  std::ostringstream ids;
+  std::ostringstream offsets;
+  {
+    morfessor::MorphIdWriter writer{ids, offsets, encoding};
+    for (const auto& word : words) {
+      writer.Add(word.data(), word.size());
+    }
+    EXPECT_EQ(words.size(), writer.words());
+  }
+
+  auto index = offsets.str();
+  ASSERT_EQ(8 * (words.size() + 1), index.size());
+  std::vector<uint64_t> starts;
+  for (size_t i = 0; i < index.size(); i += 8) {
+    uint64_t offset = 0;
+    for (size_t byte = 0; byte < 8; ++byte) {
+      offset |= static_cast<uint64_t>(
+          static_cast<unsigned char>(index[i + byte])) << (8 * byte);
+    }
+    starts.push_back(offset);
+  }
+  auto data = ids.str();
+  EXPECT_EQ(data.size(), starts.back());
+  std::vector<uint32_t> unpacked;
+  for (size_t i = 0; i < words.size(); ++i) {
+    morfessor::UnpackMorphIds(data.data() + starts[i],
+        starts[i + 1] - starts[i], encoding, unpacked);
+    EXPECT_EQ(words[i], unpacked);
+  }
+}
+
+TEST(MorphIdsTests, VarintRoundTrip) {
+  check_round_trip(MorphIdEncoding::kVarint);
+
+  // Small IDs take one byte.
+  std::ostringstream ids;
+  std::ostringstream offsets;
+  morfessor::MorphIdWriter writer{ids, offsets, MorphIdEncoding::kVarint};
+  const uint32_t small[] = {5, 127};
+  writer.Add(small, 2);
+  writer.Finish();
+  EXPECT_EQ(std::string("\x05\x7f"), ids.str());
+}
+
+TEST(MorphIdsTests, Fixed32RoundTrip) {
+  check_round_trip(MorphIdEncoding::kFixed32);
+}
+
+TEST(MorphIdsTests, UnpackRejectsTruncatedIds) {
+  std::vector<uint32_t> ids;
+  EXPECT_THROW(morfessor::UnpackMorphIds("\x85", 1,
+      MorphIdEncoding::kVarint, ids), std::runtime_error);
+  EXPECT_THROW(morfessor::UnpackMorphIds("\x01\x02\x03", 3,
+      MorphIdEncoding::kFixed32, ids), std::runtime_error);
+}
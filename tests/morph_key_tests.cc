@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "morph_key.h"
+
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+using MorphKey = morfessor::MorphKey;
+
+TEST(MorphKeyTests, ViewSharesTheLetters) {
+  std::string letters{"redoingredoingredoing"};
+  auto view = MorphKey::View(letters);
+  EXPECT_FALSE(view.owns_letters());
+  EXPECT_EQ(letters.data(), view.data());
+
+  // Copies and parts of a view view the same letters.
+  auto copy = view;
+  EXPECT_FALSE(copy.owns_letters());
+  EXPECT_EQ(letters.data(), copy.data());
+  auto part = view.substr(2, 5);
+  EXPECT_FALSE(part.owns_letters());
+  EXPECT_EQ(letters.data() + 2, part.data());
+  EXPECT_EQ("doing", part.str());
+}
+
+TEST(MorphKeyTests, CopyOwnsTheLetters) {
+  std::string letters{"redoingredoingredoing"};
+  auto key = MorphKey::Copy(letters);
+  letters.assign(letters.length(), 'x');
+  EXPECT_TRUE(key.owns_letters());
+  EXPECT_EQ("redoingredoingredoing", key.str());
+
+  auto copy = key;
+  EXPECT_TRUE(copy.owns_letters());
+  EXPECT_NE(key.data(), copy.data());
+  EXPECT_EQ(key, copy);
+
+  auto moved = std::move(copy);
+  EXPECT_TRUE(moved.owns_letters());
+  EXPECT_EQ(key, moved);
+
+  auto part = key.substr(7, 7);
+  EXPECT_TRUE(part.owns_letters());
+  EXPECT_EQ("redoing", part.str());
+}
+
+TEST(MorphKeyTests, ComparesLetters) {
+  std::string letters{"redo"};
+  auto view = MorphKey::View(letters);
+  auto copy = MorphKey::Copy("redo");
+  EXPECT_EQ(view, copy);
+  EXPECT_EQ(std::hash<MorphKey>()(view), std::hash<MorphKey>()(copy));
+  EXPECT_FALSE(view == MorphKey::View("red"));
+
+  // Ordered like strings.
+  EXPECT_TRUE(MorphKey::View("red") < view);
+  EXPECT_TRUE(view < MorphKey::View("redoing"));
+  EXPECT_TRUE(view < MorphKey::View("ref"));
+  EXPECT_FALSE(view < copy);
+  EXPECT_TRUE(MorphKey::View("z") < MorphKey::View("\xe4"));
+
+  std::unordered_set<MorphKey> keys{view};
+  EXPECT_EQ(1u, keys.count(copy));
+
+  std::ostringstream out;
+  out << view;
+  EXPECT_EQ("redo", out.str());
+}
+
+TEST(MorphKeyTests, HashLettersReadsEveryLetter) {
+  // Long enough for whole blocks of eight letters and a shorter tail.
+  std::string letters{"redoingredoingredoing"};
+  std::unordered_set<uint64_t> hashes;
+  for (size_t i = 0; i < letters.length(); ++i) {
+    auto changed = letters;
+    changed[i] = 'x';
+    hashes.insert(morfessor::HashLetters(changed.data(), changed.length()));
+  }
+  EXPECT_EQ(letters.length(), hashes.size());
+
+  // The hash does not depend on where the letters are.
+  std::string shifted = "_" + letters;
+  EXPECT_EQ(morfessor::HashLetters(letters.data(), letters.length()),
+      morfessor::HashLetters(shifted.data() + 1, letters.length()));
+  EXPECT_EQ(MorphKey::View(letters).hash(), MorphKey::Copy(letters).hash());
+}
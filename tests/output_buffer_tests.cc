@@ -0,0 +1,88 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "output_buffer.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+static std::string format_decimal(uint64_t value) {
+  char digits[20];
+  auto end = digits + sizeof(digits);
+  return std::string(morfessor::FormatDecimal(value, end), end);
+}
+
+TEST(OutputBufferTests, FormatDecimal) {
+  const uint64_t values[] = {0, 7, 10, 99, 100, 101, 12345, 1000000,
+      std::numeric_limits<uint64_t>::max()};
+  for (auto value : values) {
+    EXPECT_EQ(std::to_string(value), format_decimal(value));
+  }
+}
+
+TEST(OutputBufferTests, WritesEverythingInOrder) {
+  std::ostringstream out;
+  std::ostringstream expected;
+  {
+    // Small enough that appends fill it, and some are bigger than it.
+    morfessor::OutputBuffer buffer{out, 16};
+    for (size_t i = 0; i < 100; ++i) {
+      std::string text(i % 40, 'a' + i % 26);
+      buffer << text << ' ';
+      buffer.AppendUnsigned(i * 1001);
+      buffer << '\n';
+      expected << text << ' ' << i * 1001 << '\n';
+    }
+    buffer.AppendFixed(3465886.234420, 5);
+    buffer.AppendFixed(-0.5, 6);
+    expected << std::fixed << std::setprecision(5) << 3465886.234420
+        << std::setprecision(6) << -0.5;
+  }
+  EXPECT_EQ(expected.str(), out.str());
+}
+
+TEST(OutputBufferTests, ChunksAreWrittenInOrder) {
+  auto format = [](size_t begin, size_t end, std::string& text) {
+    for (auto i = begin; i < end; ++i) {
+      text += std::to_string(i) + "\n";
+    }
+  };
+  std::ostringstream sequential;
+  std::ostringstream parallel;
+  {
+    morfessor::OutputBuffer buffer{sequential};
+    morfessor::WriteChunks(buffer, 10000, format, 1, 64);
+  }
+  {
+    morfessor::OutputBuffer buffer{parallel};
+    morfessor::WriteChunks(buffer, 10000, format, 4, 64);
+  }
+  std::string expected;
+  format(0, 10000, expected);
+  EXPECT_EQ(expected, sequential.str());
+  EXPECT_EQ(expected, parallel.str());
+}
@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "restarts.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "segmentation.h"
+#include "corpus_loader.h"
+
+using LetterStatistics = morfessor::LetterStatistics;
+using Model = morfessor::Model;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+static morfessor::ModelFactory baseline_factory(
+    const morfessor::Corpus& corpus) {
+  return [&corpus](const LetterStatistics& letters) {
+    return std::make_shared<Model>(corpus, letters,
+        morfessor::AlgorithmModes::kBaseline, 0.5, 7.0, 1.0);
+  };
+}
+
+TEST(RestartsTests, KeepsTheCheapestConvergedRun) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto result = morfessor::OptimizeWithRestarts(corpus,
+      baseline_factory(corpus), 4, 11, 2, -1.0);
+
+  ASSERT_EQ(4, result.outcomes.size());
+  ASSERT_NE(nullptr, result.segmentation);
+  ASSERT_NE(nullptr, result.model);
+  ASSERT_LT(result.best, result.outcomes.size());
+  for (size_t i = 0; i < result.outcomes.size(); ++i) {
+    const auto& outcome = result.outcomes[i];
+    EXPECT_EQ(11 + i, outcome.seed);
+    EXPECT_FALSE(outcome.abandoned);
+    EXPECT_GT(outcome.epochs, 0);
+    EXPECT_LE(result.model->overall_cost(), outcome.overall_cost);
+  }
+  EXPECT_EQ(result.outcomes[result.best].overall_cost,
+      result.model->overall_cost());
+
+  // The kept run is the one a single run with its seed gives.
+  auto model = baseline_factory(corpus)(LetterStatistics{corpus});
+  morfessor::Segmentation single(corpus, model);
+  single.set_seed(result.outcomes[result.best].seed);
+  single.Optimize();
+  EXPECT_EQ(model->overall_cost(), result.model->overall_cost());
+  std::stringstream expected, actual;
+  single.print_as_corpus(expected);
+  result.segmentation->print_as_corpus(actual);
+  EXPECT_EQ(expected.str(), actual.str());
+}
+
+TEST(RestartsTests, AbandonsRunsThatFallBehind) {
+  const auto& corpus = corpus_loader().corpus3;
+  // With one thread the runs go one after another, and with no margin any
+  // run that is ever behind the earlier ones is abandoned.
+  auto result = morfessor::OptimizeWithRestarts(corpus,
+      baseline_factory(corpus), 6, 1, 1, 0.0);
+
+  ASSERT_EQ(6, result.outcomes.size());
+  EXPECT_FALSE(result.outcomes[0].abandoned);
+  EXPECT_FALSE(result.outcomes[result.best].abandoned);
+  for (const auto& outcome : result.outcomes) {
+    if (!outcome.abandoned) {
+      EXPECT_LE(result.model->overall_cost(), outcome.overall_cost);
+    }
+  }
+  EXPECT_TRUE(std::any_of(result.outcomes.begin(), result.outcomes.end(),
+      [](const morfessor::RestartOutcome& outcome) {
+        return outcome.abandoned;
+      }));
+}
@@ -22,8 +22,14 @@
 
 #include "segmentation.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <set>
 #include <sstream>
+#include <stdexcept>
 #include <iostream>
 
 #include <gtest/gtest.h>
@@ -153,3 +159,530 @@ TEST(SegmentationTests, BaselineFreqLengthSaneAfterSplitting) {
 
   test_against_reference(model1, s1);
 }
+
+TEST(SegmentationTests, AdjustMorphCountRemovesWholeSubtrees) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model);
+  s1.Optimize();
+
+  // Removing the words after optimizing has to walk their split trees.
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    s1.AdjustMorphCount(iter->letters(), -iter->frequency());
+  }
+  std::stringstream results;
+  s1.print_as_corpus(results);
+  EXPECT_EQ("", results.str());
+  EXPECT_EQ(0, model->total_morph_tokens());
+  EXPECT_EQ(0, model->unique_morph_types());
+  EXPECT_NEAR(0, model->morph_string_cost(), threshold);
+  EXPECT_NEAR(0, model->length_cost(), threshold);
+}
+
+TEST(SegmentationTests, UpdateAddsNewWords) {
+  // Train on the first half of the corpus, then add the second half.
+  const auto& corpus = corpus_loader().corpus3;
+  std::stringstream first_half;
+  std::stringstream second_half;
+  size_t line = 0;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter, ++line) {
+    auto& out = line < corpus.size() / 2 ? first_half : second_half;
+    out << iter->frequency() << " " << iter->letters() << std::endl;
+  }
+  // A frequency increment for a word that is already known.
+  second_half << "5 " << corpus.cbegin()->letters() << std::endl;
+  Corpus old_words{first_half};
+  Corpus new_words{second_half};
+
+  auto model = std::make_shared<BaselineLengthModel>(old_words);
+  Segmentation s1(old_words, model);
+  s1.Optimize();
+  s1.Update(new_words);
+
+  for (auto iter = new_words.cbegin(); iter != new_words.cend(); ++iter) {
+    EXPECT_TRUE(s1.contains(iter->letters()));
+  }
+  EXPECT_EQ(corpus.cbegin()->frequency() + 5,
+      s1.at(corpus.cbegin()->letters()).count);
+  test_against_reference(model, s1);
+}
+
+TEST(SegmentationTests, UpdateComesCloseToRetraining) {
+  // Update keeps the splits of the known words, so it does not reach the
+  // same result as training on all the words from scratch, but it should
+  // come close.
+  const auto& corpus = corpus_loader().corpus3;
+  std::stringstream first_half;
+  std::stringstream second_half;
+  size_t line = 0;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter, ++line) {
+    auto& out = line < corpus.size() / 2 ? first_half : second_half;
+    out << iter->frequency() << " " << iter->letters() << std::endl;
+  }
+  Corpus old_words{first_half};
+  Corpus new_words{second_half};
+
+  auto updated_model = std::make_shared<BaselineLengthModel>(old_words);
+  Segmentation updated(old_words, updated_model);
+  updated.set_seed(1);
+  updated.Optimize();
+  updated.Update(new_words);
+
+  auto retrained_model = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation retrained(corpus, retrained_model);
+  retrained.set_seed(1);
+  retrained.Optimize();
+
+  // Both were trained on the same words, so their costs compare.
+  test_against_reference(updated_model, updated);
+  EXPECT_NEAR(retrained_model->overall_cost(), updated_model->overall_cost(),
+      0.005 * retrained_model->overall_cost());
+}
+
+TEST(SegmentationTests, KeepsTheWordsOfItsCorpora) {
+  // The words are shared with the corpora rather than copied, and outlive
+  // them.
+  std::shared_ptr<Model> model;
+  std::unique_ptr<Segmentation> segmentation;
+  {
+    std::stringstream old_text{"3 redoing\n2 undoing\n"};
+    std::stringstream new_text{"4 redone\n"};
+    Corpus old_words{old_text};
+    Corpus new_words{new_text};
+    model = std::make_shared<BaselineModel>(old_words);
+    segmentation.reset(new Segmentation(old_words, model));
+    segmentation->set_seed(1);
+    segmentation->Update(new_words);
+  }
+  segmentation->Optimize();
+  EXPECT_EQ(3u, segmentation->at("redoing").count);
+  EXPECT_EQ(2u, segmentation->at("undoing").count);
+  EXPECT_EQ(4u, segmentation->at("redone").count);
+}
+
+TEST(SegmentationTests, OptimizeReportsEveryEpoch) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model);
+
+  std::vector<morfessor::EpochStats> epochs;
+  s1.set_epoch_callback([&epochs](const morfessor::EpochStats& stats) {
+    epochs.push_back(stats);
+  });
+  s1.Optimize();
+
+  ASSERT_FALSE(epochs.empty());
+  for (size_t i = 0; i < epochs.size(); ++i) {
+    EXPECT_EQ(i + 1, epochs[i].epoch);
+    EXPECT_EQ(corpus.size(), epochs[i].words_resplit);
+    EXPECT_NEAR(epochs[i].lexicon_cost + epochs[i].corpus_cost,
+        epochs[i].overall_cost, threshold);
+  }
+
+  // Optimization stops at the first epoch that does not improve enough.
+  const auto& last = epochs.back();
+  EXPECT_LE(last.cost_delta, last.convergence_threshold);
+  EXPECT_EQ(model->overall_cost(), last.overall_cost);
+  EXPECT_EQ(model->unique_morph_types(), last.unique_morph_types);
+  EXPECT_EQ(model->total_morph_tokens(), last.total_morph_tokens);
+}
+
+TEST(SegmentationTests, SameSeedGivesSameSegmentation) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto m1 = std::make_shared<BaselineModel>(corpus);
+  auto m2 = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, m1);
+  Segmentation s2(corpus, m2);
+  s1.set_seed(42);
+  s2.set_seed(42);
+  s1.Optimize();
+  s2.Optimize();
+
+  EXPECT_EQ(m1->overall_cost(), m2->overall_cost());
+  std::stringstream out1, out2;
+  s1.print_as_corpus(out1);
+  s2.print_as_corpus(out2);
+  EXPECT_EQ(out1.str(), out2.str());
+}
+
+TEST(SegmentationTests, StopEndsOptimizeAfterThePass) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model);
+
+  size_t epochs = 0;
+  s1.set_epoch_callback([&epochs, &s1](const morfessor::EpochStats&) {
+    ++epochs;
+    s1.Stop();
+  });
+  s1.Optimize();
+
+  EXPECT_EQ(1, epochs);
+  test_against_reference(model, s1);
+}
+
+TEST(SegmentationTests, ResumeFromCheckpointMatchesOriginalRun) {
+  const auto& corpus = corpus_loader().corpus3;
+  const std::string checkpoint_path = "segmentation_tests_checkpoint.txt";
+
+  // The last checkpoint is saved one pass before the run converges.
+  auto model1 = std::make_shared<BaselineFrequencyLengthModel>(corpus);
+  Segmentation s1(corpus, model1);
+  s1.set_checkpoint(checkpoint_path);
+  size_t epochs = 0;
+  s1.set_epoch_callback([&epochs](const morfessor::EpochStats& stats) {
+    epochs = stats.epoch;
+  });
+  s1.Optimize();
+  ASSERT_GT(epochs, 1);
+
+  auto model2 = std::make_shared<BaselineFrequencyLengthModel>(corpus);
+  Segmentation s2(corpus, model2);
+  std::ifstream checkpoint{checkpoint_path};
+  ASSERT_TRUE(checkpoint.is_open());
+  s2.LoadCheckpoint(checkpoint);
+  size_t resumed_epochs = 0;
+  s2.set_epoch_callback([&resumed_epochs](const morfessor::EpochStats& stats) {
+    resumed_epochs = stats.epoch;
+  });
+  s2.Optimize();
+  std::remove(checkpoint_path.c_str());
+
+  // Resuming has to reproduce the original run exactly, not just closely.
+  EXPECT_EQ(epochs, resumed_epochs);
+  EXPECT_EQ(model1->overall_cost(), model2->overall_cost());
+  EXPECT_EQ(model1->unique_morph_types(), model2->unique_morph_types());
+
+  std::stringstream results1;
+  std::stringstream results2;
+  s1.print_as_corpus(results1);
+  s2.print_as_corpus(results2);
+  std::multiset<std::string> lines1;
+  std::multiset<std::string> lines2;
+  for (std::string line; std::getline(results1, line); ) {
+    lines1.insert(line);
+  }
+  for (std::string line; std::getline(results2, line); ) {
+    lines2.insert(line);
+  }
+  EXPECT_EQ(lines1, lines2);
+}
+
+TEST(SegmentationTests, LoadCheckpointRejectsOtherFiles) {
+  auto model = std::make_shared<BaselineModel>(corpus_loader().corpus1);
+  Segmentation s1(corpus_loader().corpus1, model);
+  std::stringstream not_a_checkpoint{"1 reopen\n2 redoing\n"};
+  EXPECT_THROW(s1.LoadCheckpoint(not_a_checkpoint), std::runtime_error);
+}
+
+static std::multiset<std::string> lexicon(const Segmentation& segmentation) {
+  std::stringstream results;
+  segmentation.print_as_corpus(results);
+  std::multiset<std::string> lines;
+  for (std::string line; std::getline(results, line); ) {
+    lines.insert(line);
+  }
+  return lines;
+}
+
+TEST(SegmentationTests, SegmentWord) {
+  auto model = std::make_shared<BaselineModel>(corpus_loader().corpus1);
+  Segmentation s1(corpus_loader().corpus1, model);
+  s1.AdjustMorphCount("redoing", -2);
+  s1.AdjustMorphCount("re", 2);
+  s1.AdjustMorphCount("doing", 2);
+
+  EXPECT_EQ(std::vector<size_t>({2, 7}), s1.SegmentWord("redoing"));
+  EXPECT_EQ(std::vector<size_t>({6}), s1.SegmentWord("trying"));
+  // Unknown letters become morphs of their own.
+  EXPECT_EQ(std::vector<size_t>({2, 3, 4}), s1.SegmentWord("redo"));
+  EXPECT_TRUE(s1.SegmentWord("").empty());
+}
+
+TEST(SegmentationTests, SegmentWordKeepsFractionalCosts) {
+  // a + bc is cheaper than ab + c, but both cost 2 nats when the morph
+  // costs are rounded down to whole numbers, and the tie goes to ab + c.
+  std::istringstream words{"1 ab\n1 c\n2 a\n2 bc\n"};
+  Corpus corpus{words};
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, model);
+
+  EXPECT_EQ(std::vector<size_t>({1, 3}), s1.SegmentWord("abc"));
+}
+
+TEST(SegmentationTests, SortedParallelOutput) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, model);
+  s1.Optimize();
+
+  auto lines = [](const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);) {
+      lines.push_back(line);
+    }
+    return lines;
+  };
+  morfessor::OutputOptions options;
+  options.sorted = true;
+  options.threads = 3;
+  std::stringstream plain, sorted;
+  s1.print(plain);
+  s1.print(sorted, options);
+
+  auto plain_lines = lines(plain.str());
+  auto sorted_lines = lines(sorted.str());
+  ASSERT_FALSE(plain_lines.empty());
+  EXPECT_EQ(0, plain_lines[0].find("Overall cost: "));
+  EXPECT_EQ(plain_lines[0], sorted_lines[0]);
+  std::vector<std::string> morphs;
+  for (size_t i = 1; i < sorted_lines.size(); ++i) {
+    morphs.push_back(sorted_lines[i].substr(sorted_lines[i].find(' ') + 1));
+  }
+  EXPECT_TRUE(std::is_sorted(morphs.begin(), morphs.end()));
+  std::sort(plain_lines.begin(), plain_lines.end());
+  std::sort(sorted_lines.begin(), sorted_lines.end());
+  EXPECT_EQ(plain_lines, sorted_lines);
+
+  std::stringstream tree, sorted_tree;
+  s1.print_tree(tree);
+  s1.print_tree(sorted_tree, options);
+  auto tree_lines = lines(tree.str());
+  auto sorted_tree_lines = lines(sorted_tree.str());
+  EXPECT_EQ(s1.size(), tree_lines.size());
+  std::sort(tree_lines.begin(), tree_lines.end());
+  std::sort(sorted_tree_lines.begin(), sorted_tree_lines.end());
+  EXPECT_EQ(tree_lines, sorted_tree_lines);
+}
+
+TEST(SegmentationTests, PrintDotFilters) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, model);
+  s1.Optimize();
+
+  // Returns the nodes drawn, and adds the edges to edges.
+  auto draw = [&s1](const morfessor::DotFilter& filter,
+      std::vector<std::pair<std::string, std::string> >& edges) {
+    std::stringstream dot;
+    s1.print_dot(dot, filter);
+    std::set<std::string> nodes;
+    std::string line;
+    std::string last;
+    std::getline(dot, line);
+    EXPECT_EQ("digraph segmentation_tree {", line);
+    for (; std::getline(dot, line); last = line) {
+      auto arrow = line.find(" -> ");
+      if (arrow != std::string::npos) {
+        edges.emplace_back(line.substr(1, arrow - 2),
+            line.substr(arrow + 5, line.size() - arrow - 6));
+      } else if (line.find("[label=") != std::string::npos) {
+        nodes.insert(line.substr(1, line.find("\" [label=") - 1));
+      }
+    }
+    EXPECT_EQ("}", last);
+    for (const auto& edge : edges) {
+      EXPECT_EQ(1, nodes.count(edge.first));
+      EXPECT_EQ(1, nodes.count(edge.second));
+    }
+    return nodes;
+  };
+
+  std::vector<std::pair<std::string, std::string> > edges;
+  EXPECT_EQ(s1.size(), draw(morfessor::DotFilter(), edges).size());
+
+  // The word with the deepest tree.
+  std::string word;
+  std::set<std::string> tree;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    std::set<std::string> reachable;
+    std::vector<std::string> stack{iter->letters()};
+    while (!stack.empty()) {
+      auto morph = stack.back();
+      stack.pop_back();
+      if (!reachable.insert(morph).second) continue;
+      const auto& node = s1.at(morph);
+      if (!node.left_child.empty()) {
+        stack.push_back(node.left_child);
+        stack.push_back(node.right_child);
+      }
+    }
+    if (reachable.size() > tree.size()) {
+      word = iter->letters();
+      tree = reachable;
+    }
+  }
+  ASSERT_LT(1, tree.size());
+
+  morfessor::DotFilter filter;
+  filter.words = {word, "not a word"};
+  edges.clear();
+  EXPECT_EQ(tree, draw(filter, edges));
+  EXPECT_FALSE(edges.empty());
+
+  filter.max_depth = 1;
+  edges.clear();
+  EXPECT_EQ(std::set<std::string>{word}, draw(filter, edges));
+  EXPECT_TRUE(edges.empty());
+
+  filter.max_depth = 0;
+  filter.min_count = s1.at(word).count + 1;
+  edges.clear();
+  EXPECT_TRUE(draw(filter, edges).empty());
+
+  // Without words, the trees start at the morphs no other morph splits
+  // into, and every drawn morph is counted often enough.
+  filter.words.clear();
+  filter.min_count = 2;
+  edges.clear();
+  auto frequent = draw(filter, edges);
+  EXPECT_FALSE(frequent.empty());
+  for (const auto& morph : frequent) {
+    EXPECT_LE(2, s1.at(morph).count);
+  }
+}
+
+TEST(SegmentationTests, SegmentTestCorpusSinks) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, model);
+  s1.Optimize();
+  auto expected = s1.SegmentTestCorpus(corpus);
+
+  size_t index = 0;
+  auto word = corpus.cbegin();
+  s1.SegmentTestCorpus(corpus, [&](const std::string& letters,
+      const size_t* boundaries, size_t morph_count) {
+    EXPECT_EQ(word->letters(), letters);
+    EXPECT_EQ(s1.SegmentWord(letters),
+        std::vector<size_t>(boundaries, boundaries + morph_count));
+    ++word;
+    ++index;
+  });
+  EXPECT_EQ(corpus.size(), index);
+
+  std::vector<std::string> lines;
+  s1.SegmentTestCorpusLines(corpus, [&lines](const std::string& line) {
+    lines.push_back(line);
+  });
+  EXPECT_EQ(*expected, lines);
+}
+
+TEST(SegmentationTests, SegmentWordKBest) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation s1(corpus, model);
+  s1.set_seed(1);
+  s1.Optimize();
+
+  // Costs of every segmentation of the word, found by trying every set of
+  // boundaries.
+  auto log_token_count = std::log(model->total_morph_tokens());
+  auto all_costs = [&](const std::string& word) {
+    std::vector<double> costs;
+    auto splits = word.length() - 1;
+    for (size_t mask = 0; mask < (size_t{1} << splits); ++mask) {
+      double cost = 0;
+      size_t start_index = 0;
+      bool known = true;
+      for (size_t end_index = 1; end_index <= word.length(); ++end_index) {
+        if (end_index < word.length() && !(mask & (1 << (end_index - 1)))) {
+          continue;
+        }
+        auto morph = word.substr(start_index, end_index - start_index);
+        if (s1.contains(morph)) {
+          cost += log_token_count - std::log(s1.at(morph).count);
+        } else if (morph.length() == 1) {
+          cost += (word.length() + 1) * log_token_count;
+        } else {
+          known = false;
+        }
+        start_index = end_index;
+      }
+      if (known) {
+        costs.push_back(cost);
+      }
+    }
+    std::sort(costs.begin(), costs.end());
+    return costs;
+  };
+
+  for (std::string word : {"abandoned", "tracking", "unbearably", "xq"}) {
+    auto paths = s1.SegmentWord(word, 5);
+    auto expected = all_costs(word);
+    ASSERT_EQ(std::min<size_t>(5, expected.size()), paths.size()) << word;
+    EXPECT_EQ(s1.SegmentWord(word), paths[0].boundaries) << word;
+    std::set<std::vector<size_t> > distinct;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      EXPECT_NEAR(expected[i], paths[i].cost, threshold) << word;
+      EXPECT_EQ(word.length(), paths[i].boundaries.back()) << word;
+      distinct.insert(paths[i].boundaries);
+    }
+    EXPECT_EQ(paths.size(), distinct.size()) << word;
+  }
+
+  // A single letter has one segmentation, whatever k is.
+  EXPECT_EQ(1, s1.SegmentWord("a", 10).size());
+}
+
+TEST(SegmentationTests, WarmStartFromTree) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model1 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model1);
+  s1.Optimize();
+  std::stringstream tree;
+  s1.print_tree(tree);
+
+  auto model2 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s2(corpus, model2);
+  s2.WarmStart(tree);
+
+  // Same corpus and same splits, so the same lexicon and cost.
+  EXPECT_EQ(lexicon(s1), lexicon(s2));
+  EXPECT_NEAR(model1->overall_cost(), model2->overall_cost(), threshold);
+  test_against_reference(model2, s2);
+}
+
+TEST(SegmentationTests, OptimizeAfterWarmStartResplitsOnlyWords) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model1 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model1);
+  s1.Optimize();
+  std::stringstream tree;
+  s1.print_tree(tree);
+
+  auto model2 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s2(corpus, model2);
+  s2.WarmStart(tree);
+  std::vector<morfessor::EpochStats> epochs;
+  s2.set_epoch_callback([&epochs](const morfessor::EpochStats& stats) {
+    epochs.push_back(stats);
+  });
+  s2.Optimize();
+
+  ASSERT_FALSE(epochs.empty());
+  EXPECT_EQ(corpus.size(), epochs.front().words_resplit);
+  test_against_reference(model2, s2);
+}
+
+TEST(SegmentationTests, WarmStartFromModel) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model1 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s1(corpus, model1);
+  s1.Optimize();
+  std::stringstream results;
+  s1.print_as_corpus(results);
+  Corpus previous_lexicon{results};
+  auto previous_model = std::make_shared<BaselineLengthModel>(
+      previous_lexicon);
+  Segmentation previous(previous_lexicon, previous_model);
+
+  auto model2 = std::make_shared<BaselineLengthModel>(corpus);
+  Segmentation s2(corpus, model2);
+  auto unsplit_cost = model2->overall_cost();
+  s2.WarmStart(previous);
+
+  test_against_reference(model2, s2);
+  EXPECT_LT(model2->overall_cost(), unsplit_cost);
+}
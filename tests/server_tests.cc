@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "server.h"
+
+#include <unistd.h>
+
+#include <csignal>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "corpus_loader.h"
+
+using BaselineModel = morfessor::BaselineModel;
+using Segmentation = morfessor::Segmentation;
+using SegmentationServer = morfessor::SegmentationServer;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+// Sends input through a pipe to the server and returns everything it
+// answers on another pipe.
+static std::string serve(SegmentationServer& server,
+    const std::string& input) {
+  int requests[2];
+  int answers[2];
+  EXPECT_EQ(0, pipe(requests));
+  EXPECT_EQ(0, pipe(answers));
+  std::thread client([&]() {
+    EXPECT_EQ(static_cast<ssize_t>(input.size()),
+        write(requests[1], input.data(), input.size()));
+    close(requests[1]);
+  });
+  std::thread server_thread([&]() {
+    server.Serve(requests[0], answers[1]);
+    close(answers[1]);
+  });
+  std::string output;
+  char buffer[256];
+  ssize_t length;
+  while ((length = read(answers[0], buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, length);
+  }
+  client.join();
+  server_thread.join();
+  close(requests[0]);
+  close(answers[0]);
+  return output;
+}
+
+TEST(ServerTests, AnswersEveryLineInOrder) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+
+  std::string input;
+  std::string expected;
+  auto segments = segmentation.SegmentTestCorpus(corpus);
+  auto segment = segments->cbegin();
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    input += iter->letters() + "\n";
+    expected += *segment++ + "\n";
+  }
+  // Empty lines get empty answers, and the last word needs no newline.
+  input += "\nreading";
+  expected += "\n";
+  std::string word = "reading";
+  size_t start_index = 0;
+  for (auto end_index : segmentation.SegmentWord(word)) {
+    expected += word.substr(start_index, end_index - start_index) + " ";
+    start_index = end_index;
+  }
+  expected += "\n";
+
+  SegmentationServer server(segmentation, 3, 2);
+  EXPECT_EQ(expected, serve(server, input));
+}
+
+TEST(ServerTests, NoInput) {
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  SegmentationServer server(segmentation, 1);
+  EXPECT_EQ("", serve(server, ""));
+}
+
+TEST(ServerTests, StopsWhenTheOutputIsClosed) {
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  SegmentationServer server(segmentation, 1, 1);
+
+  // Like the morfessor program in --serve mode, so the write to the
+  // closed pipe fails with EPIPE.
+  auto old_handler = std::signal(SIGPIPE, SIG_IGN);
+  int requests[2];
+  int answers[2];
+  ASSERT_EQ(0, pipe(requests));
+  ASSERT_EQ(0, pipe(answers));
+  close(answers[0]);
+  std::thread client([&]() {
+    std::string input;
+    for (int i = 0; i < 1000; ++i) {
+      input += "reading\n";
+    }
+    // The server may stop reading before all of it is written.
+    auto unused = write(requests[1], input.data(), input.size());
+    (void)unused;
+    close(requests[1]);
+  });
+  server.Serve(requests[0], answers[1]);
+  close(requests[0]);
+  client.join();
+  close(answers[1]);
+  std::signal(SIGPIPE, old_handler);
+}
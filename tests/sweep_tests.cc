@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sweep.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "evaluation.h"
+#include "model.h"
+#include "corpus_loader.h"
+
+using AlgorithmModes = morfessor::AlgorithmModes;
+using SweepConfiguration = morfessor::SweepConfiguration;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+TEST(SweepTests, GridSkipsUnusedParameters) {
+  auto grid = morfessor::MakeSweepGrid(
+      {AlgorithmModes::kBaseline, AlgorithmModes::kBaselineFreq,
+       AlgorithmModes::kBaselineLength, AlgorithmModes::kBaselineFreqLength},
+      {0.3, 0.5}, {6.0, 7.0, 8.0}, {1.0});
+  // 1 + 2 + 3 + 2*3
+  ASSERT_EQ(12, grid.size());
+  EXPECT_EQ(AlgorithmModes::kBaseline, grid[0].mode);
+  EXPECT_EQ(0.3, grid[0].hapax);
+  EXPECT_EQ(6.0, grid[0].most_common_length);
+  EXPECT_EQ(AlgorithmModes::kBaselineFreq, grid[2].mode);
+  EXPECT_EQ(0.5, grid[2].hapax);
+  EXPECT_EQ(6.0, grid[2].most_common_length);
+  EXPECT_EQ(AlgorithmModes::kBaselineLength, grid[5].mode);
+  EXPECT_EQ(0.3, grid[5].hapax);
+  EXPECT_EQ(8.0, grid[5].most_common_length);
+  EXPECT_EQ(AlgorithmModes::kBaselineFreqLength, grid[11].mode);
+  EXPECT_EQ(0.5, grid[11].hapax);
+  EXPECT_EQ(8.0, grid[11].most_common_length);
+
+  grid = morfessor::MakeSweepGrid({AlgorithmModes::kBaselineFreq}, {}, {},
+      {});
+  ASSERT_EQ(1, grid.size());
+  EXPECT_EQ(SweepConfiguration{}.hapax, grid[0].hapax);
+}
+
+TEST(SweepTests, TrainsEveryConfigurationInOrder) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto grid = morfessor::MakeSweepGrid(
+      {AlgorithmModes::kBaseline, AlgorithmModes::kBaselineFreq},
+      {0.3, 0.7}, {}, {});
+
+  // Every word is its own gold standard analysis.
+  std::string lines;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    lines += iter->letters() + "\t" + iter->letters() + "\n";
+  }
+  std::istringstream in{lines};
+  morfessor::GoldStandard gold{in};
+
+  auto results = morfessor::Sweep(corpus, grid, 2, &corpus, &gold);
+  ASSERT_EQ(grid.size(), results.size());
+  morfessor::BaselineModel unsplit(corpus);
+  for (size_t i = 0; i < grid.size(); ++i) {
+    EXPECT_EQ(grid[i].mode, results[i].configuration.mode);
+    EXPECT_EQ(grid[i].hapax, results[i].configuration.hapax);
+    EXPECT_NEAR(results[i].overall_cost,
+        results[i].lexicon_cost + results[i].corpus_cost, 0.001);
+    EXPECT_LT(results[i].unique_morph_types, corpus.size());
+    EXPECT_TRUE(results[i].evaluated);
+    EXPECT_EQ(corpus.size(), results[i].score.evaluated_words);
+    EXPECT_EQ(0, results[i].score.hits);
+    EXPECT_EQ(0, results[i].score.deletions);
+  }
+  // Training improves on the unsplit words.
+  EXPECT_LT(results[0].overall_cost, unsplit.overall_cost());
+
+  std::ostringstream out;
+  morfessor::print_table(out, results);
+  auto table = out.str();
+  EXPECT_NE(std::string::npos, table.find("Baseline"));
+  EXPECT_NE(std::string::npos, table.find("recall"));
+  EXPECT_EQ(grid.size() + 1, std::count(table.begin(), table.end(), '\n'));
+}
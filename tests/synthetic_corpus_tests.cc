@@ -0,0 +1,185 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "synthetic_corpus.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+
+using Corpus = morfessor::Corpus;
+using SyntheticCorpusGenerator = morfessor::SyntheticCorpusGenerator;
+using SyntheticCorpusOptions = morfessor::SyntheticCorpusOptions;
+
+static std::string generate(const SyntheticCorpusOptions& options,
+    std::string* gold = nullptr) {
+  SyntheticCorpusGenerator generator(options);
+  std::ostringstream words;
+  std::ostringstream gold_stream;
+  generator.Generate(words, &gold_stream);
+  if (gold) {
+    *gold = gold_stream.str();
+  }
+  return words.str();
+}
+
+TEST(SyntheticCorpusTests, WritesDistinctWordsMostFrequentFirst) {
+  SyntheticCorpusOptions options;
+  options.word_types = 2000;
+  options.morph_types = 300;
+  std::istringstream words(generate(options));
+
+  Corpus corpus(words);
+  ASSERT_EQ(2000, corpus.size());
+  std::unordered_set<std::string> seen;
+  size_t previous = options.max_count;
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    EXPECT_TRUE(seen.insert(iter->letters()).second);
+    EXPECT_LE(iter->frequency(), previous);
+    EXPECT_GE(iter->frequency(), 1);
+    previous = iter->frequency();
+  }
+  EXPECT_EQ(options.max_count, corpus.cbegin()->frequency());
+}
+
+TEST(SyntheticCorpusTests, GoldSegmentationSpellsTheWord) {
+  SyntheticCorpusOptions options;
+  options.word_types = 500;
+  options.morph_types = 100;
+  options.min_morphs = 2;
+  options.max_morphs = 3;
+  std::string gold;
+  std::istringstream words(generate(options, &gold));
+  SyntheticCorpusGenerator generator(options);
+  std::unordered_set<std::string> inventory(generator.morphs().begin(),
+      generator.morphs().end());
+
+  std::istringstream gold_lines(gold);
+  std::string line;
+  size_t count;
+  std::string word;
+  while (words >> count >> word) {
+    ASSERT_TRUE(getline(gold_lines, line));
+    auto tab = line.find('\t');
+    ASSERT_NE(std::string::npos, tab);
+    EXPECT_EQ(word, line.substr(0, tab));
+    std::istringstream morphs(line.substr(tab + 1));
+    std::string morph;
+    std::string spelled;
+    size_t morph_count = 0;
+    while (morphs >> morph) {
+      EXPECT_EQ(1, inventory.count(morph));
+      spelled += morph;
+      ++morph_count;
+    }
+    EXPECT_EQ(word, spelled);
+    EXPECT_GE(morph_count, 2);
+    EXPECT_LE(morph_count, 3);
+  }
+  EXPECT_FALSE(getline(gold_lines, line));
+}
+
+TEST(SyntheticCorpusTests, SameSeedSameOutput) {
+  SyntheticCorpusOptions options;
+  options.word_types = 1000;
+  auto first = generate(options);
+  EXPECT_EQ(first, generate(options));
+  options.seed = 2;
+  EXPECT_NE(first, generate(options));
+}
+
+TEST(SyntheticCorpusTests, CommonMorphsAreUsedMore) {
+  SyntheticCorpusOptions options;
+  options.word_types = 5000;
+  options.morph_types = 200;
+  std::string gold;
+  generate(options, &gold);
+  SyntheticCorpusGenerator generator(options);
+  const auto& inventory = generator.morphs();
+
+  std::istringstream gold_lines(gold);
+  std::string word;
+  std::string morphs;
+  size_t first = 0;
+  size_t last = 0;
+  while (getline(gold_lines, word, '\t') && getline(gold_lines, morphs)) {
+    std::istringstream morph_stream(morphs);
+    std::string morph;
+    while (morph_stream >> morph) {
+      first += morph == inventory.front();
+      last += morph == inventory.back();
+    }
+  }
+  EXPECT_GT(first, 10 * last);
+}
+
+TEST(SyntheticCorpusTests, UsesAGivenInventory) {
+  SyntheticCorpusOptions options;
+  options.min_morphs = 1;
+  options.max_morphs = 1;
+  std::vector<std::string> morphs;
+  for (char letter = 'a'; letter <= 'z'; ++letter) {
+    morphs.push_back(std::string(3, letter));
+  }
+  // With one morph per word, there are only as many words as morphs.
+  options.word_types = morphs.size();
+  SyntheticCorpusGenerator generator(options, morphs);
+  EXPECT_EQ(morphs, generator.morphs());
+  std::ostringstream words;
+  generator.Generate(words, nullptr);
+  std::istringstream lines(words.str());
+  Corpus corpus(lines);
+  ASSERT_EQ(morphs.size(), corpus.size());
+  std::unordered_set<std::string> inventory(morphs.begin(), morphs.end());
+  for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+    EXPECT_EQ(1, inventory.count(iter->letters()));
+  }
+}
+
+TEST(SyntheticCorpusTests, ThrowsWhenTheInventoryIsTooSmall) {
+  SyntheticCorpusOptions options;
+  options.word_types = 100;
+  options.min_morphs = 1;
+  options.max_morphs = 1;
+  SyntheticCorpusGenerator generator(options, {"a", "b", "c"});
+  std::ostringstream words;
+  EXPECT_THROW(generator.Generate(words, nullptr), std::runtime_error);
+}
+
+TEST(SyntheticCorpusTests, RejectsBadOptions) {
+  SyntheticCorpusOptions options;
+  options.alphabet = "ab";
+  options.max_morph_length = 3;
+  EXPECT_THROW(SyntheticCorpusGenerator{options}, std::invalid_argument);
+  options = SyntheticCorpusOptions{};
+  options.min_morphs = 3;
+  options.max_morphs = 2;
+  EXPECT_THROW(SyntheticCorpusGenerator{options}, std::invalid_argument);
+  EXPECT_THROW(SyntheticCorpusGenerator(SyntheticCorpusOptions{}, {}),
+      std::invalid_argument);
+}
@@ -0,0 +1,163 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "text_segmenter.h"
+
+#include <unistd.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "corpus.h"
+#include "model.h"
+#include "corpus_loader.h"
+
+using BaselineModel = morfessor::BaselineModel;
+using Segmentation = morfessor::Segmentation;
+using TextSegmenter = morfessor::TextSegmenter;
+static auto corpus_loader = &morfessor::tests::corpus_loader;
+
+// Sends text through a pipe to the segmenter and returns everything it
+// writes on another pipe.
+static std::string segment(TextSegmenter& segmenter, const std::string& text,
+    morfessor::TextStats* stats = nullptr) {
+  int input[2];
+  int output[2];
+  EXPECT_EQ(0, pipe(input));
+  EXPECT_EQ(0, pipe(output));
+  std::thread writer([&]() {
+    EXPECT_EQ(static_cast<ssize_t>(text.size()),
+        write(input[1], text.data(), text.size()));
+    close(input[1]);
+  });
+  std::thread segmenter_thread([&]() {
+    auto result = segmenter.Segment(input[0], output[1]);
+    if (stats) {
+      *stats = result;
+    }
+    close(output[1]);
+  });
+  std::string segmented;
+  char buffer[256];
+  ssize_t length;
+  while ((length = read(output[0], buffer, sizeof(buffer))) > 0) {
+    segmented.append(buffer, length);
+  }
+  writer.join();
+  segmenter_thread.join();
+  close(input[0]);
+  close(output[0]);
+  return segmented;
+}
+
+// Segments text one token at a time.
+static std::string expected_segmentation(const Segmentation& segmentation,
+    const std::string& text, const std::string& separator) {
+  std::string expected;
+  size_t index = 0;
+  while (index < text.size()) {
+    auto token_start = text.find_first_not_of(" \t\n\v\f\r", index);
+    expected.append(text, index, token_start - index);
+    if (token_start == std::string::npos) {
+      break;
+    }
+    auto token_end = text.find_first_of(" \t\n\v\f\r", token_start);
+    auto token = text.substr(token_start, token_end - token_start);
+    size_t start_index = 0;
+    for (auto end_index : segmentation.SegmentWord(token)) {
+      if (start_index > 0) {
+        expected += separator;
+      }
+      expected.append(token, start_index, end_index - start_index);
+      start_index = end_index;
+    }
+    index = token_end;
+  }
+  return expected;
+}
+
+static std::string running_text(const morfessor::Corpus& corpus) {
+  // Every word a few times, with all sorts of whitespace between them.
+  const char* spaces[] = {" ", "  ", "\t", "\n", "\r\n", " \n\n"};
+  std::string text = "  ";
+  size_t i = 0;
+  for (int repeat = 0; repeat < 3; ++repeat) {
+    for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+      text += iter->letters();
+      text += spaces[i++ % 6];
+    }
+  }
+  return text + "unfinished";
+}
+
+TEST(TextSegmenterTests, KeepsWhitespaceAndOrder) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+  auto text = running_text(corpus);
+
+  // Blocks of a few bytes cut the text in many places, some inside long
+  // words.
+  for (size_t block_size : {5, 64, 1 << 20}) {
+    TextSegmenter segmenter(segmentation, "+", 3, block_size);
+    morfessor::TextStats stats;
+    EXPECT_EQ(expected_segmentation(segmentation, text, "+"),
+        segment(segmenter, text, &stats)) << block_size;
+    EXPECT_EQ(text.size(), stats.bytes);
+    EXPECT_EQ(3 * corpus.size() + 1, stats.tokens);
+  }
+}
+
+TEST(TextSegmenterTests, DecodesEachTokenOnce) {
+  const auto& corpus = corpus_loader().corpus3;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  segmentation.Optimize();
+  auto text = running_text(corpus);
+
+  TextSegmenter segmenter(segmentation, " + ", 1, 256);
+  morfessor::TextStats stats;
+  auto segmented = segment(segmenter, text, &stats);
+  EXPECT_EQ(corpus.size() + 1, stats.decoded);
+
+  // The cache outlives a call.
+  EXPECT_EQ(segmented, segment(segmenter, text, &stats));
+  EXPECT_EQ(0, stats.decoded);
+
+  TextSegmenter uncached(segmentation, " + ", 1, 256, 0);
+  EXPECT_EQ(segmented, segment(uncached, text, &stats));
+  EXPECT_EQ(stats.tokens, stats.decoded);
+}
+
+TEST(TextSegmenterTests, NoInput) {
+  const auto& corpus = corpus_loader().corpus1;
+  auto model = std::make_shared<BaselineModel>(corpus);
+  Segmentation segmentation(corpus, model);
+  TextSegmenter segmenter(segmentation, " + ", 1);
+  EXPECT_EQ("", segment(segmenter, ""));
+  EXPECT_EQ(" \n\t\n", segment(segmenter, " \n\t\n"));
+}
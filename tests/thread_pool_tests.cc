@@ -0,0 +1,60 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Derek Felson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using ThreadPool = morfessor::ThreadPool;
+
+TEST(ThreadPoolTests, RunsEveryTask) {
+  std::atomic<int> runs{0};
+  std::vector<std::future<int> > results;
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(4u, pool.size());
+    for (int i = 0; i < 100; ++i) {
+      results.push_back(pool.Submit([i, &runs]() {
+        ++runs;
+        return i * i;
+      }));
+    }
+  }
+  // The d'tor finishes the queued tasks.
+  EXPECT_EQ(100, runs);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * i, results[i].get());
+  }
+}
+
+TEST(ThreadPoolTests, PassesOnExceptions) {
+  ThreadPool pool(1);
+  auto result = pool.Submit([]() -> int {
+    throw std::runtime_error("task failed");
+  });
+  EXPECT_THROW(result.get(), std::runtime_error);
+}